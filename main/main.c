@@ -5,15 +5,29 @@
 #include "driver/gpio.h"
 
 #include "i2c_interface.h"
+#include "spi_interface.h"
 #include "oled_128x64.h"
 
 #include "my_logo.XBM"
+#include "my_logo_packed.h"
 #include "data/font_terminus_14x28_iso8859_1.h" 
 
 // --- Constants & Config ---
+// 1: 4-wire SPI module on HSPI, 0: I2C module
+#ifndef OLED_USE_SPI
+#define OLED_USE_SPI    0
+#endif
+
+#if OLED_USE_SPI
+#define LED_GPIO        2   // GPIO15 is the HSPI chip select
+#else
 #define LED_GPIO        15
+#endif
 #define TEST_DELAY_MS   3000
 
+// D/C# bit of the SSD1306 control byte, selects the D/C pin level on SPI
+#define OLED_CONTROL_DC(control)    (((control) & 0x40) ? 1 : 0)
+
 // --- Prototypes ---
 extern void led_blink_init(uint32_t led_gpio_no, uint32_t led_on_time_ms, uint32_t led_off_time_ms);
 uint32_t oled_listener(oled_info_t *info);
@@ -28,17 +42,25 @@ void app_main()
     // 1. Initialize Status LED
     led_blink_init(LED_GPIO, 300, 1000);
 
-    // 2. Initialize I2C
+    // 2. Initialize the display bus
+#if OLED_USE_SPI
+    if(spi_interface_init() != 0) {
+        printf("\n[Error] SPI Init Failed!\n");
+        return;
+    }
+    printf("\n[Info] SPI Initialized");
+#else
     if(i2c_interface_init() != 0) {
         printf("\n[Error] I2C Init Failed!\n");
         return;
     }
     printf("\n[Info] I2C Initialized");
+#endif
 
     // 3. Initialize OLED
     // We pass the listener callback to the driver here
     int retry = 0;
-    while(oled_init(&oled_listener) != 0)
+    while(oled_init_transport(&oled_listener, OLED_TRANSPORT_SEGMENTS) != 0)
     {
         printf("\n[Error] OLED Init Failed, Retrying...");
         vTaskDelay(500 / portTICK_PERIOD_MS);
@@ -48,7 +70,21 @@ void app_main()
         }
     }
     printf("\n[Info] OLED Initialized");
+
+#if defined(I2C_INTERFACE_BENCHMARK) && !OLED_USE_SPI
+    // Stream dummy data to the OLED (address 0x3C, data control byte 0x40)
+    i2c_interface_benchmark((0x3C << 1), 0x40);
+#endif
+
+#ifdef OLED_BENCHMARK
+    // Frame buffer kernels against per pixel drawing, no bus traffic
+    oled_benchmark();
+#endif
     
+    // Boot splash, streamed to the panel from the packed logo
+    oled_show_packed_image(NULL, &my_logo_packed);
+    vTaskDelay(TEST_DELAY_MS / portTICK_PERIOD_MS);
+
     oled_clear_display();
 
     // 4. Main Test Loop
@@ -104,11 +140,50 @@ uint32_t oled_listener(oled_info_t *info)
     uint32_t ret_val = 0;
     switch(info->info_type)
     {
+#if OLED_USE_SPI
+        case OLED_SEND_DATA:
+            // SPI has no address or control byte, the control byte selects the D/C pin level
+            ret_val = spi_interface_write(OLED_CONTROL_DC(info->register_add), info->data, info->data_len);
+        break;
+
+        case OLED_SEND_SEGMENTS:
+            // Segments are streamed through the HSPI FIFO back to back
+            if(info->segment_count > SPI_INTERFACE_MAX_SEGMENTS) {
+                ret_val = 1;
+                break;
+            }
+            {
+                spi_interface_segment_t segments[SPI_INTERFACE_MAX_SEGMENTS];
+                for(uint32_t i = 0; i < info->segment_count; i++) {
+                    segments[i].data = info->segments[i].data;
+                    segments[i].data_len = info->segments[i].data_len;
+                }
+                ret_val = spi_interface_write_segments(OLED_CONTROL_DC(info->register_add), segments, info->segment_count);
+            }
+        break;
+#else
         case OLED_SEND_DATA:
             // Pass the data buffer directly to the I2C interface
             ret_val = i2c_interface_write_register(info->address, info->register_add, info->data, info->data_len);
         break;
 
+        case OLED_SEND_SEGMENTS:
+            // Send all segments in one I2C transaction, payload is referenced and not copied
+            if(info->segment_count > I2C_INTERFACE_MAX_SEGMENTS) {
+                ret_val = 1;
+                break;
+            }
+            {
+                i2c_interface_segment_t segments[I2C_INTERFACE_MAX_SEGMENTS];
+                for(uint32_t i = 0; i < info->segment_count; i++) {
+                    segments[i].data = info->segments[i].data;
+                    segments[i].data_len = info->segments[i].data_len;
+                }
+                ret_val = i2c_interface_write_segments(info->address, info->register_add, segments, info->segment_count);
+            }
+        break;
+#endif
+
         case OLED_FUNCTION_YEILD:
             // Yield to FreeRTOS scheduler to prevent Watchdog timeouts during long frame updates
             vTaskDelay(0); // yield
@@ -48,6 +48,15 @@ typedef enum
     FONT_FACE_TERMINUS_BOLD_16X32_KOI8_R,
 } font_face_t;
 
+/**
+ * Bitmap layout of a font
+ */
+typedef enum
+{
+    FONT_FORMAT_ROWS = 0, ///< Row-major, each row padded to whole bytes, leftmost pixel in bit 7
+    FONT_FORMAT_PAGES,    ///< Page-major as SSD1306 GDDRAM: one byte per column and 8 rows, top row in bit 0
+} font_format_t;
+
 /**
  * Character descriptor
  */
@@ -68,6 +77,7 @@ typedef struct _font_info
     char char_end;                            ///< Last character
     const font_char_desc_t *char_descriptors; ///< descriptor for each character
     const uint8_t *bitmap;                    ///< Character bitmap
+    uint8_t format;                           ///< Bitmap layout, see font_format_t. Fonts that leave it out are row-major
 } font_info_t;
 
 /**
@@ -84,9 +94,10 @@ extern const size_t font_builtin_fonts_count;
  */
 inline const font_char_desc_t *font_get_char_desc(const font_info_t *fnt, char c)
 {
-    return c < fnt->char_start || c > fnt->char_end
+    // Compared unsigned, characters above 0x7F are negative where char is signed
+    return (uint8_t)c < (uint8_t)fnt->char_start || (uint8_t)c > (uint8_t)fnt->char_end
         ? NULL
-        : fnt->char_descriptors + c - fnt->char_start;
+        : fnt->char_descriptors + ((uint8_t)c - (uint8_t)fnt->char_start);
 }
 
 /**
@@ -8,16 +8,33 @@ import jinja2
 import re
 import time
 
-def gen_char(index, c, im):
+def gen_char(index, c, im, layout):
     bw = (im.size[0] + 7) // 8
+    pages = (im.size[1] + 7) // 8
     res = {
         'index': index,
         'code': c,
         'offset': bw * im.size[1] * index,
-        'rows': []
+        'rows': [],
+        'pages': []
     }
     
     data = tuple(im.getdata())
+
+    if layout == 'pages':
+        # SSD1306 native: one byte per column and 8 row page, top row in bit 0,
+        # all columns of the first page, then all columns of the next one
+        res['offset'] = im.size[0] * pages * index
+        for page in range(pages):
+            p = []
+            for col in range(im.size[0]):
+                byte = 0
+                for bit in range(8):
+                    row = page * 8 + bit
+                    if row < im.size[1] and data[row * im.size[0] + col]:
+                        byte |= 1 << bit
+                p.append(byte)
+            res['pages'].append(p)
     
     for row in range(im.size[1]):
         r = {
@@ -57,7 +74,7 @@ def main(args):
     for idx in range(args.last - args.first + 1):
         draw.rectangle(((0, 0), size), fill = 0)
         draw.text((0, 0), chr(idx + args.first), font=fnt)
-        chars.append(gen_char(idx, idx + args.first, im.convert('1')))
+        chars.append(gen_char(idx, idx + args.first, im.convert('1'), args.layout))
         
     env = jinja2.Environment(loader=jinja2.FileSystemLoader(os.path.dirname(os.path.abspath(__file__))), finalize=lambda x: '' if x is None else x)
     print(env.get_template(args.template).render({
@@ -67,6 +84,7 @@ def main(args):
             'charset': args.charset,
             'first': args.first,
             'last': args.last,
+            'layout': args.layout,
         },
         'chars': chars,
         'created': time.ctime()
@@ -86,5 +104,6 @@ if __name__ == "__main__":
     parser.add_argument('--first', type=int, help='First character', default=1)
     parser.add_argument('--last', type=int, help='Last character', default=255)
     parser.add_argument('-t', '--template', type=str, help='Template filename', default='template.c')
+    parser.add_argument('-l', '--layout', choices=('rows', 'pages'), help='Bitmap layout: row-major, or page-major columns as SSD1306 GDDRAM', default='rows')
     main(parser.parse_args(sys.argv[1:]))
 
@@ -26,9 +26,18 @@ static const uint8_t {{ font_prefix }}_bitmaps[] = {
     {%- for char in chars %}
 
     /* {{ 'Index: 0x%02x, char: \\x%02x, offset: 0x%04x'|format(char.index, char.code, char.offset) }} */
+    {%- if font.layout == 'pages' %}
+    {%- for row in char.rows %}
+    /* {{ row.asc }} */
+    {%- endfor %}
+    {%- for page in char.pages %}
+    {% for byte in page %}{{ '0x%02x'|format(byte) }}, {% endfor -%} /* page {{ loop.index0 }} */
+    {%- endfor -%}
+    {%- else %}
     {%- for row in char.rows %}
     {% for byte in row.data %}{{ '0x%02x'|format(byte) }}, {% endfor -%} /* {{ row.asc }} */
     {%- endfor -%}
+    {%- endif -%}
     {%- endfor %}
 };
 
@@ -46,6 +55,7 @@ const font_info_t {{ font_prefix }}_info =
     .char_end         = {{ font.last }}, /* End character */
     .char_descriptors = {{ font_prefix }}_descriptors, /* Character descriptor array */
     .bitmap           = {{ font_prefix }}_bitmaps, /* Character bitmap array */
+    .format           = {{ 'FONT_FORMAT_PAGES' if font.layout == 'pages' else 'FONT_FORMAT_ROWS' }}, /* Bitmap layout */
 };
 
 #endif /* {{ header_id }} */
@@ -3,6 +3,9 @@
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "rom/ets_sys.h"
+#include "esp_timer.h"
 
 
 #ifdef I2C_INTERFACE_DEBUG
@@ -11,7 +14,340 @@
 #define i2c_debug(fmt, ...)
 #endif
 
+#if defined(I2C_INTERFACE_BENCHMARK) && I2C_INTERFACE_STATIC_LINKS
+#error "I2C_INTERFACE_BENCHMARK compares the SDK link paths, build it without I2C_INTERFACE_STATIC_LINKS"
+#endif
+
+#if I2C_INTERFACE_DISPLAY_GRANT_BYTES < 32
+#error "I2C_INTERFACE_DISPLAY_GRANT_BYTES below 32 spends more time on addressing than on payload"
+#endif
+
+typedef enum
+{
+    I2C_BUS_IDLE = 0,
+    I2C_BUS_DISPLAY,
+    I2C_BUS_SENSOR
+} i2c_bus_owner_t;
+
+// Bus arbiter. Display writes are cut into grants of at most I2C_INTERFACE_DISPLAY_GRANT_BYTES,
+// the lock is released after each grant and a waiting sensor transfer always goes next.
+static SemaphoreHandle_t g_bus_lock;
+static SemaphoreHandle_t g_sensors_idle;      /*!< given when the last waiting sensor transfer is done */
+static volatile uint32_t g_sensors_waiting;
+static volatile i2c_bus_owner_t g_bus_owner;
+static i2c_interface_bus_stats_t g_bus_stats;
+
+static uint32_t i2c_bus_write(uint8_t address, uint8_t register_add, const i2c_interface_segment_t *segments, uint32_t segment_count);
+static uint32_t i2c_bus_read(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len);
+
+// Created once at init, so steady state transfers never touch the heap
+static uint32_t i2c_arbiter_init(void)
+{
+    if(g_bus_lock == NULL)
+    {
+        g_bus_lock = xSemaphoreCreateMutex();
+        g_sensors_idle = xSemaphoreCreateBinary();
+        if(g_bus_lock == NULL || g_sensors_idle == NULL)
+        {
+            i2c_debug("Line 36: bus lock error");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint32_t i2c_bus_take_display(void)
+{
+    if(xSemaphoreTake(g_bus_lock, 200/portTICK_PERIOD_MS) != pdTRUE)
+    {
+        return 1;
+    }
+    // Sensors waiting for the bus go first
+    while(g_sensors_waiting)
+    {
+        xSemaphoreGive(g_bus_lock);
+        // A timeout only means the sensors are still busy, the display keeps waiting for them
+        while(xSemaphoreTake(g_sensors_idle, 200/portTICK_PERIOD_MS) != pdTRUE && g_sensors_waiting)
+        {
+        }
+        if(xSemaphoreTake(g_bus_lock, 200/portTICK_PERIOD_MS) != pdTRUE)
+        {
+            return 1;
+        }
+    }
+    g_bus_owner = I2C_BUS_DISPLAY;
+    return 0;
+}
+
+static uint32_t i2c_bus_take_sensor(void)
+{
+    uint32_t ret_val = 0;
+    int64_t start = esp_timer_get_time();
+
+    taskENTER_CRITICAL();
+    g_sensors_waiting++;
+    uint8_t display_busy = (g_bus_owner == I2C_BUS_DISPLAY);
+    taskEXIT_CRITICAL();
+
+    if(xSemaphoreTake(g_bus_lock, 200/portTICK_PERIOD_MS) != pdTRUE)
+    {
+        ret_val = 1;
+    }
+
+    taskENTER_CRITICAL();
+    g_sensors_waiting--;
+    taskEXIT_CRITICAL();
+
+    if(ret_val)
+    {
+        i2c_debug("Line 50: bus busy");
+        if(g_sensors_waiting == 0)
+        {
+            xSemaphoreGive(g_sensors_idle);
+        }
+        return 1;
+    }
+
+    g_bus_owner = I2C_BUS_SENSOR;
+    g_bus_stats.sensor_transfers++;
+    if(display_busy)
+    {
+        uint32_t wait_us = (uint32_t)(esp_timer_get_time() - start);
+        if(wait_us > g_bus_stats.sensor_wait_max_us)
+        {
+            g_bus_stats.sensor_wait_max_us = wait_us;
+        }
+    }
+    return 0;
+}
+
+static void i2c_bus_give(void)
+{
+    i2c_bus_owner_t owner = g_bus_owner;
+    g_bus_owner = I2C_BUS_IDLE;
+    xSemaphoreGive(g_bus_lock);
+    if(owner == I2C_BUS_SENSOR && g_sensors_waiting == 0)
+    {
+        xSemaphoreGive(g_sensors_idle);
+    }
+}
+
+
+#if I2C_INTERFACE_STATIC_LINKS
+
+#define I2C_INTERFACE_HALF_PERIOD_US    2       /*!< about 200 kHz including gpio overhead */
+#define I2C_INTERFACE_STRETCH_US        210     /*!< same clock stretch limit as the SDK driver setup */
+
+/**
+ * Command link living in static storage. A node only references the caller's
+ * buffer, so building a transaction neither allocates nor copies payload.
+ */
+typedef struct
+{
+    uint8_t header[2];                          /*!< address and register byte */
+    const uint8_t *data[I2C_INTERFACE_MAX_SEGMENTS];
+    uint32_t data_len[I2C_INTERFACE_MAX_SEGMENTS];
+    uint8_t nodes;
+} i2c_link_t;
+
+// Only used with the bus lock held
+static i2c_link_t g_link;
+
+static inline void i2c_bb_delay(void)
+{
+    ets_delay_us(I2C_INTERFACE_HALF_PERIOD_US);
+}
+
+// Let SCL go high and wait while the slave stretches the clock
+static uint32_t i2c_bb_scl_release(void)
+{
+    gpio_set_level(I2C_SCL_PIN, 1);
+    for(uint32_t t = 0; gpio_get_level(I2C_SCL_PIN) == 0; t++)
+    {
+        if(t >= I2C_INTERFACE_STRETCH_US)
+        {
+            return 1;
+        }
+        ets_delay_us(1);
+    }
+    return 0;
+}
+
+static uint32_t i2c_bb_start(void)
+{
+    gpio_set_level(I2C_SDA_PIN, 1);
+    if(i2c_bb_scl_release())
+    {
+        return 1;
+    }
+    i2c_bb_delay();
+    gpio_set_level(I2C_SDA_PIN, 0);
+    i2c_bb_delay();
+    gpio_set_level(I2C_SCL_PIN, 0);
+    return 0;
+}
+
+static void i2c_bb_stop(void)
+{
+    gpio_set_level(I2C_SDA_PIN, 0);
+    i2c_bb_delay();
+    i2c_bb_scl_release();
+    i2c_bb_delay();
+    gpio_set_level(I2C_SDA_PIN, 1);
+    i2c_bb_delay();
+}
+
+// Clock out one byte MSB first, returns non-zero on NACK or stretch timeout
+static uint32_t i2c_bb_write_byte(uint8_t byte)
+{
+    uint32_t nack = 0;
+    for(uint8_t mask = 0x80; mask; mask >>= 1)
+    {
+        gpio_set_level(I2C_SDA_PIN, (byte & mask) ? 1 : 0);
+        i2c_bb_delay();
+        if(i2c_bb_scl_release())
+        {
+            return 1;
+        }
+        i2c_bb_delay();
+        gpio_set_level(I2C_SCL_PIN, 0);
+    }
+    gpio_set_level(I2C_SDA_PIN, 1);
+    i2c_bb_delay();
+    if(i2c_bb_scl_release())
+    {
+        return 1;
+    }
+    i2c_bb_delay();
+    nack = gpio_get_level(I2C_SDA_PIN);
+    gpio_set_level(I2C_SCL_PIN, 0);
+    return nack;
+}
+
+// Clock in one byte MSB first, then ACK it or NACK the last byte of a read
+static uint32_t i2c_bb_read_byte(uint8_t *byte, uint8_t nack)
+{
+    uint8_t value = 0;
+    gpio_set_level(I2C_SDA_PIN, 1);
+    for(uint8_t bit = 0; bit < 8; bit++)
+    {
+        i2c_bb_delay();
+        if(i2c_bb_scl_release())
+        {
+            return 1;
+        }
+        i2c_bb_delay();
+        value = (value << 1) | (gpio_get_level(I2C_SDA_PIN) ? 1 : 0);
+        gpio_set_level(I2C_SCL_PIN, 0);
+    }
+    gpio_set_level(I2C_SDA_PIN, nack ? 1 : 0);
+    i2c_bb_delay();
+    if(i2c_bb_scl_release())
+    {
+        return 1;
+    }
+    i2c_bb_delay();
+    gpio_set_level(I2C_SCL_PIN, 0);
+    *byte = value;
+    return 0;
+}
+
+static uint32_t i2c_link_execute(const i2c_link_t *link)
+{
+    uint32_t ret_val = i2c_bb_start();
+    for(uint32_t i = 0; !ret_val && i < sizeof(link->header); i++)
+    {
+        ret_val = i2c_bb_write_byte(link->header[i]);
+    }
+    for(uint8_t n = 0; !ret_val && n < link->nodes; n++)
+    {
+        for(uint32_t i = 0; !ret_val && i < link->data_len[n]; i++)
+        {
+            ret_val = i2c_bb_write_byte(link->data[n][i]);
+        }
+    }
+    i2c_bb_stop();
+    return ret_val;
+}
+
+uint32_t i2c_interface_init(void)
+{
+    uint32_t ret_val = 0;
+    gpio_config_t conf = 
+    {
+        (1 << I2C_SDA_PIN) | (1 << I2C_SCL_PIN),
+        GPIO_MODE_OUTPUT_OD,
+        GPIO_PULLUP_ENABLE,
+        GPIO_PULLDOWN_DISABLE,
+        GPIO_INTR_DISABLE
+    };
+    if(gpio_config(&conf))
+    {
+        ret_val = 1;
+        i2c_debug("Line 31: gpio config error");
+    }
+    gpio_set_level(I2C_SDA_PIN, 1);
+    gpio_set_level(I2C_SCL_PIN, 1);
+
+    if(i2c_arbiter_init())
+    {
+        ret_val = 1;
+    }
+    return ret_val;
+}
+
+static uint32_t i2c_bus_write(uint8_t address, uint8_t register_add, const i2c_interface_segment_t *segments, uint32_t segment_count)
+{
+    uint32_t ret_val = 0;
+    g_link.header[0] = address|I2C_MASTER_WRITE;
+    g_link.header[1] = register_add;
+    for(uint32_t n = 0; n < segment_count; n++)
+    {
+        g_link.data[n] = segments[n].data;
+        g_link.data_len[n] = segments[n].data_len;
+    }
+    g_link.nodes = segment_count;
+    if(i2c_link_execute(&g_link))
+    {
+        i2c_debug("Line 60: no ack from %x", address);
+        ret_val = 1;
+    }
+    return ret_val;
+}
 
+static uint32_t i2c_bus_read(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len)
+{
+    uint32_t ret_val = i2c_bb_start();
+    if(!ret_val)
+    {
+        ret_val = i2c_bb_write_byte(address|I2C_MASTER_WRITE);
+    }
+    if(!ret_val)
+    {
+        ret_val = i2c_bb_write_byte(register_add);
+    }
+    // Repeated start, then switch to reading
+    if(!ret_val)
+    {
+        ret_val = i2c_bb_start();
+    }
+    if(!ret_val)
+    {
+        ret_val = i2c_bb_write_byte(address|I2C_MASTER_READ);
+    }
+    for(uint32_t i = 0; !ret_val && i < data_len; i++)
+    {
+        ret_val = i2c_bb_read_byte(&data[i], (i == data_len - 1));
+    }
+    i2c_bb_stop();
+    if(ret_val)
+    {
+        i2c_debug("Line 60: no ack from %x", address);
+    }
+    return ret_val;
+}
+
+#else
 
 uint32_t i2c_interface_init(void)
 {
@@ -34,11 +370,14 @@ uint32_t i2c_interface_init(void)
         ret_val = 1;
         i2c_debug("Line 36: param config error");
     }
+    if(i2c_arbiter_init())
+    {
+        ret_val = 1;
+    }
     return ret_val;
 }
 
-
-uint32_t i2c_interface_write_register(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len)
+static uint32_t i2c_bus_write(uint8_t address, uint8_t register_add, const i2c_interface_segment_t *segments, uint32_t segment_count)
 {
     
     uint32_t ret_val = 0;
@@ -67,16 +406,14 @@ uint32_t i2c_interface_write_register(uint8_t address, uint8_t register_add, uin
             i2c_debug("Line 58: send bytes write byte error");
         }
     }
-    if(!ret_val)
+    for(uint32_t n = 0; !ret_val && n < segment_count; n++)
     {
-        for(uint32_t i = 0;  i < data_len; i++)
+        // Queue each block as a single link node instead of one node per byte.
+        // The driver only reads through the pointer.
+        if(segments[n].data_len && i2c_master_write(cmd, (uint8_t *)segments[n].data, segments[n].data_len, true))
         {
-            i2c_debug("Line 65: %x", *(data + i));
-            if(i2c_master_write_byte(cmd, *(data + i), true))
-            {
-                ret_val = 1;
-                i2c_debug("Line 69: send bytes write byte error");
-            }
+            ret_val = 1;
+            i2c_debug("Line 69: send bytes write error");
         }
     }    
     if(!ret_val)
@@ -99,6 +436,195 @@ uint32_t i2c_interface_write_register(uint8_t address, uint8_t register_add, uin
     return ret_val;
 }
 
+static uint32_t i2c_bus_read(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len)
+{
+    uint32_t ret_val = 0;
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+
+    ret_val |= (i2c_master_start(cmd) != 0);
+    ret_val |= (i2c_master_write_byte(cmd, address|I2C_MASTER_WRITE, true) != 0);
+    ret_val |= (i2c_master_write_byte(cmd, register_add, true) != 0);
+    // Repeated start, then switch to reading
+    ret_val |= (i2c_master_start(cmd) != 0);
+    ret_val |= (i2c_master_write_byte(cmd, address|I2C_MASTER_READ, true) != 0);
+    ret_val |= (i2c_master_read(cmd, data, data_len, I2C_MASTER_LAST_NACK) != 0);
+    ret_val |= (i2c_master_stop(cmd) != 0);
+    if(!ret_val)
+    {
+        if(i2c_master_cmd_begin(I2C_NUM_0, cmd, 200/portTICK_PERIOD_MS))
+        {
+            i2c_debug("Line 85: cmd begin error");
+            ret_val = 1;                
+        }
+    }
+    i2c_cmd_link_delete(cmd);
+    return ret_val;
+}
+
+#endif
+
+
+uint32_t i2c_interface_write_segments(uint8_t address, uint8_t register_add, const i2c_interface_segment_t *segments, uint32_t segment_count)
+{
+    uint32_t ret_val = 0;
+    i2c_interface_segment_t grant[I2C_INTERFACE_MAX_SEGMENTS];
+    uint32_t grant_count = 0;
+    uint32_t grant_len = 0;
+    uint32_t offset = 0;
+    uint32_t n = 0;
+
+    if(segment_count > I2C_INTERFACE_MAX_SEGMENTS)
+    {
+        i2c_debug("Line 50: too many segments %u", segment_count);
+        return 1;
+    }
+
+    // Each grant is one transaction of at most I2C_INTERFACE_DISPLAY_GRANT_BYTES, 
+    // a longer write continues in the next one after register_add again.
+    // An SSD1306 control byte stream carries on across transactions.
+    while(!ret_val && (n < segment_count || grant_count))
+    {
+        if(n < segment_count && grant_len < I2C_INTERFACE_DISPLAY_GRANT_BYTES)
+        {
+            uint32_t len = segments[n].data_len - offset;
+            if(len > I2C_INTERFACE_DISPLAY_GRANT_BYTES - grant_len)
+            {
+                len = I2C_INTERFACE_DISPLAY_GRANT_BYTES - grant_len;
+            }
+            grant[grant_count].data = segments[n].data + offset;
+            grant[grant_count].data_len = len;
+            grant_count++;
+            grant_len += len;
+            offset += len;
+            if(offset == segments[n].data_len)
+            {
+                n++;
+                offset = 0;
+            }
+            if(n < segment_count && grant_len < I2C_INTERFACE_DISPLAY_GRANT_BYTES)
+            {
+                continue;
+            }
+        }
+
+        if(i2c_bus_take_display())
+        {
+            i2c_debug("Line 50: bus busy");
+            return 1;
+        }
+        ret_val = i2c_bus_write(address, register_add, grant, grant_count);
+        g_bus_stats.display_grants++;
+        i2c_bus_give();
+        grant_count = 0;
+        grant_len = 0;
+    }
+    return ret_val;
+}
+
+uint32_t i2c_interface_sensor_write(uint8_t address, uint8_t register_add, const uint8_t *data, uint32_t data_len)
+{
+    uint32_t ret_val = 0;
+    i2c_interface_segment_t segment = { data, data_len };
+    if(i2c_bus_take_sensor())
+    {
+        return 1;
+    }
+    ret_val = i2c_bus_write(address, register_add, &segment, 1);
+    i2c_bus_give();
+    return ret_val;
+}
+
+uint32_t i2c_interface_sensor_read(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len)
+{
+    uint32_t ret_val = 0;
+    if(data_len == 0)
+    {
+        return 0;
+    }
+    if(i2c_bus_take_sensor())
+    {
+        return 1;
+    }
+    ret_val = i2c_bus_read(address, register_add, data, data_len);
+    i2c_bus_give();
+    return ret_val;
+}
+
+void i2c_interface_get_bus_stats(i2c_interface_bus_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = g_bus_stats;
+    taskEXIT_CRITICAL();
+}
+
+void i2c_interface_reset_bus_stats(void)
+{
+    taskENTER_CRITICAL();
+    g_bus_stats.display_grants = 0;
+    g_bus_stats.sensor_transfers = 0;
+    g_bus_stats.sensor_wait_max_us = 0;
+    taskEXIT_CRITICAL();
+}
+
+uint32_t i2c_interface_write_register(uint8_t address, uint8_t register_add, const uint8_t *data, uint32_t data_len)
+{
+    i2c_interface_segment_t segment = { data, data_len };
+    return i2c_interface_write_segments(address, register_add, &segment, 1);
+}
+
+#ifdef I2C_INTERFACE_BENCHMARK
+
+#define I2C_BENCHMARK_CHUNK_SIZE    128
+#define I2C_BENCHMARK_ROUNDS        64
+
+// Former write path, one link node per payload byte. Kept only for comparison.
+static uint32_t i2c_interface_write_register_bytewise(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len)
+{
+    uint32_t ret_val = 0;
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+
+    ret_val |= (i2c_master_start(cmd) != 0);
+    ret_val |= (i2c_master_write_byte(cmd, address|I2C_MASTER_WRITE, true) != 0);
+    ret_val |= (i2c_master_write_byte(cmd, register_add, true) != 0);
+    for(uint32_t i = 0;  i < data_len; i++)
+    {
+        ret_val |= (i2c_master_write_byte(cmd, *(data + i), true) != 0);
+    }
+    ret_val |= (i2c_master_stop(cmd) != 0);
+    if(!ret_val)
+    {
+        ret_val = (i2c_master_cmd_begin(I2C_NUM_0, cmd, 200/portTICK_PERIOD_MS) != 0);
+    }
+    i2c_cmd_link_delete(cmd);
+    return ret_val;
+}
+
+void i2c_interface_benchmark(uint8_t address, uint8_t register_add)
+{
+    static uint8_t chunk[I2C_BENCHMARK_CHUNK_SIZE];
+    int64_t start = 0;
+    int64_t bytewise_us = 0;
+    int64_t bulk_us = 0;
+
+    start = esp_timer_get_time();
+    for(uint32_t i = 0; i < I2C_BENCHMARK_ROUNDS; i++)
+    {
+        i2c_interface_write_register_bytewise(address, register_add, chunk, sizeof(chunk));
+    }
+    bytewise_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for(uint32_t i = 0; i < I2C_BENCHMARK_ROUNDS; i++)
+    {
+        i2c_interface_write_register(address, register_add, chunk, sizeof(chunk));
+    }
+    bulk_us = esp_timer_get_time() - start;
+
+    printf("\n[Bench] %d byte chunk: per byte %u us, bulk %u us", I2C_BENCHMARK_CHUNK_SIZE, 
+           (unsigned int)(bytewise_us / I2C_BENCHMARK_ROUNDS), (unsigned int)(bulk_us / I2C_BENCHMARK_ROUNDS));
+}
+#endif
+
 #if 0
 uint32_t i2c_interface_send_bytes(uint8_t address, uint8_t *data, uint32_t data_len)
 {
@@ -7,8 +7,50 @@
 #define I2C_SDA_PIN                 GPIO_NUM_4               /*!< gpio number for I2C master data  */
 #define I2C_MASTER_PORT_NUM         I2C_NUM_0        /*!< I2C port number for master dev */
 
+/* 1: drive the bus from command links in static storage, no heap use per transaction.
+   0: use the SDK driver, which allocates a command link for every transaction. */
+#ifndef I2C_INTERFACE_STATIC_LINKS
+#define I2C_INTERFACE_STATIC_LINKS  0
+#endif
+
+/* Most payload bytes a display write may send per bus grant. Longer writes are split and a waiting
+   sensor transfer runs between grants, so a sensor waits for at most one grant of display traffic. */
+#ifndef I2C_INTERFACE_DISPLAY_GRANT_BYTES
+#define I2C_INTERFACE_DISPLAY_GRANT_BYTES   128
+#endif
+
+#define I2C_INTERFACE_MAX_SEGMENTS  16
+
+/* One piece of a vectored write, referenced and never copied */
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t data_len;
+} i2c_interface_segment_t;
+
+/* Bus arbiter counters */
+typedef struct
+{
+    uint32_t display_grants;        /*!< display transactions sent */
+    uint32_t sensor_transfers;      /*!< sensor reads and writes */
+    uint32_t sensor_wait_max_us;    /*!< longest time a sensor waited for display traffic to release the bus */
+} i2c_interface_bus_stats_t;
 
 uint32_t i2c_interface_init(void);
-uint32_t i2c_interface_write_register(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len);
+uint32_t i2c_interface_write_register(uint8_t address, uint8_t register_add, const uint8_t *data, uint32_t data_len);
+/* Write register_add followed by all segments, one start/stop transaction per display grant */
+uint32_t i2c_interface_write_segments(uint8_t address, uint8_t register_add, const i2c_interface_segment_t *segments, uint32_t segment_count);
+
+/* Sensor transfers, served before any display grant still waiting for the bus */
+uint32_t i2c_interface_sensor_write(uint8_t address, uint8_t register_add, const uint8_t *data, uint32_t data_len);
+/* Write register_add, then read data_len bytes after a repeated start */
+uint32_t i2c_interface_sensor_read(uint8_t address, uint8_t register_add, uint8_t *data, uint32_t data_len);
+void i2c_interface_get_bus_stats(i2c_interface_bus_stats_t *stats);
+void i2c_interface_reset_bus_stats(void);
+
+#ifdef I2C_INTERFACE_BENCHMARK
+/* Print the time per 128 byte chunk for the per byte and the bulk write paths */
+void i2c_interface_benchmark(uint8_t address, uint8_t register_add);
+#endif
 
 #endif
@@ -0,0 +1,50 @@
+/**
+ * Packed page-major image generated by pack_image.py from my_logo.XBM
+ * 128x64 pixels, 423 bytes packed from 1024
+ * Created: Sat Oct 17 06:27:57 2026
+ */
+#ifndef __MY_LOGO_PACKED_H__
+#define __MY_LOGO_PACKED_H__
+
+#include "oled_128x64.h"
+
+static const uint8_t my_logo_packed_data[] = {
+    0xc3, 0x00, 0x0b, 0x80, 0x00, 0x80, 0x00, 0x00, 0x80, 0x00, 0x00, 0x80, 0x00, 0x00, 0x80, 0xd6,
+    0x00, 0x07, 0x80, 0x80, 0xc0, 0xc0, 0xe0, 0xe0, 0xf0, 0xf0, 0x80, 0xf8, 0x80, 0xfc, 0x82, 0xfe,
+    0x9a, 0xff, 0x01, 0xfe, 0xff, 0x83, 0xfe, 0x83, 0xfc, 0x81, 0xf8, 0x80, 0xf0, 0x80, 0xe0, 0x03,
+    0xc0, 0xc0, 0x80, 0x80, 0xa9, 0x00, 0x06, 0x80, 0xc0, 0xf0, 0xf8, 0xf8, 0xfc, 0xfe, 0x8c, 0xff,
+    0x80, 0x7f, 0x80, 0x3f, 0x83, 0x1f, 0x85, 0x0f, 0x0c, 0x07, 0x0f, 0x07, 0x07, 0x0f, 0x07, 0x0f,
+    0x07, 0x07, 0x0f, 0x07, 0x07, 0xc7, 0x80, 0xcf, 0x00, 0xe7, 0x83, 0xcf, 0x03, 0x8f, 0x8f, 0x9f,
+    0x0f, 0x84, 0x1f, 0x83, 0x3f, 0x81, 0x7f, 0x06, 0x7e, 0x7c, 0xfc, 0xf8, 0xf0, 0xc0, 0x80, 0x9d,
+    0x00, 0x01, 0x40, 0xfc, 0x87, 0xff, 0x80, 0x7f, 0x83, 0x3f, 0x0b, 0xff, 0xff, 0xfd, 0xf8, 0xf0,
+    0xf0, 0xe0, 0xe0, 0xc0, 0xc0, 0x80, 0x80, 0x84, 0x00, 0x04, 0x18, 0x3c, 0x3c, 0x7e, 0x7e, 0x80,
+    0xff, 0x0f, 0xfe, 0xfc, 0xfc, 0xf0, 0xf0, 0xe0, 0xc0, 0x80, 0x00, 0x00, 0x01, 0x81, 0x87, 0x87,
+    0x8f, 0xdf, 0x85, 0xff, 0x03, 0xfe, 0xfe, 0xfc, 0xe0, 0x8f, 0x00, 0x00, 0x01, 0x8b, 0x00, 0x80,
+    0xc0, 0x01, 0x80, 0xc0, 0x81, 0x80, 0x88, 0x00, 0x05, 0x07, 0x0f, 0x1f, 0x3f, 0x3f, 0x7f, 0x82,
+    0xff, 0x0f, 0xfe, 0xfe, 0xfc, 0xf0, 0xf0, 0xe0, 0xc0, 0x80, 0x00, 0x00, 0x01, 0x01, 0x07, 0x07,
+    0x0f, 0x1f, 0x82, 0x3f, 0x03, 0x1f, 0x1f, 0x0e, 0x04, 0x87, 0x00, 0x05, 0x01, 0x01, 0x03, 0x83,
+    0x87, 0xc7, 0x91, 0xff, 0x02, 0x7f, 0x1f, 0x0f, 0x9f, 0x00, 0x08, 0x01, 0x03, 0x07, 0x0f, 0x1f,
+    0x3f, 0x3f, 0x7f, 0x7f, 0x80, 0xff, 0x01, 0xfe, 0xff, 0x82, 0xfe, 0x01, 0xfc, 0xfe, 0x84, 0xfc,
+    0x03, 0xf8, 0xfc, 0xfd, 0xf8, 0x81, 0xf9, 0x88, 0xf8, 0x00, 0xfc, 0x80, 0xf8, 0x01, 0xfc, 0xf8,
+    0x82, 0xfc, 0x01, 0xfe, 0xfc, 0x81, 0xfe, 0x8f, 0xff, 0x08, 0x7f, 0x7f, 0x3f, 0x1f, 0x1f, 0x0f,
+    0x07, 0x01, 0x01, 0xad, 0x00, 0x01, 0x01, 0x01, 0x81, 0x03, 0x80, 0x07, 0x01, 0x0f, 0x07, 0x80,
+    0x0f, 0x85, 0x1f, 0x85, 0x3f, 0x05, 0x7f, 0x3f, 0x7f, 0x3f, 0x7f, 0x3f, 0x86, 0x7f, 0x09, 0x3f,
+    0x7f, 0x7f, 0x3f, 0x3f, 0x7f, 0x3f, 0x3f, 0x1f, 0x3f, 0x82, 0x1f, 0x01, 0x0f, 0x0f, 0x80, 0x07,
+    0x80, 0x03, 0x00, 0x01, 0xb7, 0x00, 0x0b, 0x04, 0x06, 0x01, 0x06, 0x01, 0x04, 0x08, 0x06, 0x04,
+    0x00, 0x0c, 0x02, 0x80, 0x00, 0x25, 0x06, 0x06, 0x08, 0x06, 0x00, 0x06, 0x00, 0x04, 0x06, 0x08,
+    0x06, 0x00, 0x0c, 0x02, 0x0c, 0x04, 0x00, 0x04, 0x04, 0x06, 0x00, 0x04, 0x0c, 0x06, 0x04, 0x00,
+    0x0e, 0x02, 0x0c, 0x02, 0x00, 0x0c, 0x00, 0x04, 0x00, 0x0e, 0x04, 0x0c, 0x80, 0x00, 0x15, 0x04,
+    0x06, 0x06, 0x04, 0x06, 0x02, 0x04, 0x0c, 0x06, 0x00, 0x08, 0x0c, 0x0a, 0x04, 0x00, 0x0c, 0x04,
+    0x0e, 0x00, 0x08, 0x06, 0x02, 0x97, 0x00,
+};
+
+static const oled_packed_image_t my_logo_packed = {
+    .x        = 0,
+    .page     = 0,
+    .width    = 128,
+    .pages    = 8,
+    .data     = my_logo_packed_data,
+    .data_len = sizeof(my_logo_packed_data),
+};
+
+#endif /* __MY_LOGO_PACKED_H__ */
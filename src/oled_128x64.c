@@ -10,6 +10,8 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 
 #ifdef OLED_DEBUG
 #define oled_debug(fmt, ...) printf("\n %s: " fmt , "oled", ## __VA_ARGS__)
@@ -19,19 +21,398 @@
 
 #define OLED_HEIGHT     64
 #define OLED_WIDTH      128
+#define OLED_PAGES      (OLED_HEIGHT / 8)
 
 // Optimization: Send 128 bytes (1 page) at a time to minimize I2C Start/Stop overhead
 // 128 bytes fits well within standard I2C timeouts and buffers
 #define OLED_I2C_CHUNK_SIZE 128 
 
+// Keep a shadow copy of GDDRAM so a flush only sends bytes that really changed.
+// Costs one extra frame of RAM, build with OLED_SHADOW_BUFFER=0 to drop it.
+#ifndef OLED_SHADOW_BUFFER
+#define OLED_SHADOW_BUFFER  1
+#endif
+
+// Single page windows are sent in page addressing mode, which positions the
+// pointer with 3 command bytes instead of 6. Build with 0 to always use horizontal mode.
+#ifndef OLED_PAGE_ADDRESSING
+#define OLED_PAGE_ADDRESSING    1
+#endif
+
+// Transfer cost model, in bus byte times. Start and stop together count as one byte.
+#define OLED_XFER_TXN_COST          3   // start/stop + address + control byte
+#define OLED_XFER_WINDOW_CMD_BYTES  6   // column range + page range commands
+#define OLED_XFER_WINDOW_COST       (2 * OLED_XFER_TXN_COST + OLED_XFER_WINDOW_CMD_BYTES)
+#if OLED_PAGE_ADDRESSING
+#define OLED_XFER_PAGE_CMD_BYTES    3   // page start + column start nibbles
+#else
+#define OLED_XFER_PAGE_CMD_BYTES    OLED_XFER_WINDOW_CMD_BYTES
+#endif
+#define OLED_XFER_PAGE_WINDOW_COST  (2 * OLED_XFER_TXN_COST + OLED_XFER_PAGE_CMD_BYTES)
+#define OLED_XFER_FULL_FRAME_COST   (OLED_XFER_TXN_COST + OLED_XFER_WINDOW_CMD_BYTES + \
+                                     (OLED_WIDTH * OLED_PAGES / OLED_I2C_CHUNK_SIZE) * (OLED_XFER_TXN_COST + OLED_I2C_CHUNK_SIZE))
+
+// Upper bound of windows a single flush may use before falling back to a full frame
+#define OLED_PLAN_MAX_WINDOWS       32
+
+// Most segments a single vectored transaction carries
+#define OLED_MAX_SEGMENTS           16
+
+// Flush task streaming the front buffer while the application draws the next frame
+#ifndef OLED_FLUSH_TASK_STACK
+#define OLED_FLUSH_TASK_STACK       2048
+#endif
+#ifndef OLED_FLUSH_TASK_PRIORITY
+#define OLED_FLUSH_TASK_PRIORITY    4
+#endif
+
+// Highest rate oled_set_frame_rate() accepts, well above what the bus can carry and
+// far from a pacing period that rounds down to 0 us
+#ifndef OLED_FRAME_RATE_MAX
+#define OLED_FRAME_RATE_MAX         1000
+#endif
+
+// Portrait drawing canvas, rotated into the frame when it is presented.
+// Costs one extra frame of RAM per display, build with OLED_PORTRAIT_CANVAS=0 to drop it.
+#ifndef OLED_PORTRAIT_CANVAS
+#define OLED_PORTRAIT_CANVAS    1
+#endif
+
+// Most pages a frame can have, the portrait canvas is OLED_WIDTH rows high
+#define OLED_FRAME_PAGES_MAX    (OLED_WIDTH / 8)
+
+// Number of panels one firmware image can drive. Each one holds three frames, the portrait
+// canvas and the shadow buffer, about 5.4 KB of RAM by default; OLED_PORTRAIT_CANVAS=0 and
+// OLED_SHADOW_BUFFER=0 take about 1 KB off each.
+#ifndef OLED_MAX_DISPLAYS
+#define OLED_MAX_DISPLAYS           1
+#endif
+
+// RAM cache of glyphs already converted to GDDRAM column bytes, so the text that is redrawn
+// every frame is neither read from flash nor transposed again. The budget is
+// SLOTS * SLOT_BYTES, glyphs larger than a slot are drawn straight from the font.
+// Build with OLED_GLYPH_CACHE_SLOTS=0 to drop the cache.
+#ifndef OLED_GLYPH_CACHE_SLOTS
+#define OLED_GLYPH_CACHE_SLOTS      32
+#endif
+#ifndef OLED_GLYPH_CACHE_SLOT_BYTES
+#define OLED_GLYPH_CACHE_SLOT_BYTES 64  // 16x32 glyph
+#endif
+
+// Most lines oled_draw_text_box() lays out, 8 pixel lines on the 128 row portrait canvas
+#ifndef OLED_TEXT_MAX_LINES
+#define OLED_TEXT_MAX_LINES         16
+#endif
+
 typedef uint32_t (*oled_callback_ptr)(oled_info_t *info);
-static oled_callback_ptr fire_oled_info;
 
-static uint32_t oled_send(oled_info_type_t info_type, uint8_t  address, uint8_t register_add, uint8_t *data, uint32_t data_len);
+/**
+ * One frame buffer plus the dirty column window of each of its pages.
+ * Only dirty windows are pushed on a flush, a page is clean when x0 > x1.
+ * Frames sent to the panel are OLED_WIDTH x OLED_HEIGHT, the portrait canvas
+ * uses the same layout with width and height swapped.
+ * Pages are logical, page 0 is shown at the top. GDDRAM is used as a ring:
+ * logical page n is stored in GDDRAM page (n + ring) % OLED_PAGES and the 
+ * display start line is set to ring * 8.
+ */
+typedef struct {
+    union {
+        uint8_t buffer[OLED_WIDTH * OLED_PAGES];
+        uint32_t words[OLED_WIDTH * OLED_PAGES / 4];    // Same bytes, for the word-wide kernels
+    };
+    uint8_t dirty_x0[OLED_FRAME_PAGES_MAX];
+    uint8_t dirty_x1[OLED_FRAME_PAGES_MAX];
+    uint32_t seq;
+    uint8_t ring;
+    uint8_t width;                      // Columns, also the length of a page row
+    uint8_t height;                     // Rows, a multiple of 8
+} oled_frame_t;
 
-static uint8_t g_frame_buffer[OLED_WIDTH * (OLED_HEIGHT/8)];
+typedef struct {
+    uint8_t x0;
+    uint8_t x1;
+    uint8_t page0;
+    uint8_t page1;
+} oled_window_t;
 
-uint32_t oled_init(uint32_t (*oled_callback)(oled_info_t *info)) 
+// Shortest run of a packed image, control bytes 0x80..0xFF repeat the next byte (n & 0x7F) + 3 times
+#define OLED_PACKED_MIN_RUN         3
+
+// Page byte that ends an animation delta
+#define OLED_ANIM_DELTA_END         0xFF
+
+// Longest command stream batched into one transaction
+#define OLED_CMD_BATCH_MAX          16
+
+// Register value not known, e.g. before init
+#define OLED_REG_UNKNOWN            0xFFFF
+
+/**
+ * What the controller registers were last set to, so commands that would not
+ * change anything are left out. Single byte commands store the command byte.
+ */
+typedef struct {
+    uint16_t addr_mode;
+    uint16_t col0;
+    uint16_t col1;
+    uint16_t page0;
+    uint16_t page1;
+    uint8_t ptr_at_start;               // Horizontal mode: GDDRAM pointer at (col0, page0), as after a complete window
+    uint16_t ptr_col;                   // Page mode: GDDRAM pointer
+    uint16_t ptr_page;
+    uint16_t seg_remap;
+    uint16_t com_scan;
+    uint16_t contrast;
+    uint16_t start_line;
+    uint16_t display_on;
+    uint16_t inverse;
+} oled_regs_t;
+
+typedef struct {
+    uint8_t buf[OLED_CMD_BATCH_MAX];
+    uint8_t len;
+} oled_cmd_batch_t;
+
+/**
+ * Everything that belongs to one panel.
+ * The application draws into the back frame and submits it to the mailbox.
+ * The flush task takes the latest frame from the mailbox into the front slot and streams it.
+ * All hand overs swap pointers.
+ */
+typedef struct oled_dev {
+    uint8_t in_use;
+    uint8_t address;                    // 7 bit I2C address
+    oled_callback_ptr fire_oled_info;
+    uint32_t transport_flags;
+
+    oled_frame_t frames[3];
+    oled_frame_t *back;
+    oled_frame_t *mailbox;
+    oled_frame_t *front;
+    uint8_t mailbox_full;
+
+    uint32_t submit_seq;
+    uint32_t done_seq;
+    oled_frame_stats_t frame_stats;
+
+    esp_timer_handle_t pace_timer;
+    uint32_t frame_rate;
+    uint8_t flush_due;                  // Set by the pacing timer
+    uint8_t panel_ring;                 // Ring offset the display start line is set to
+    oled_regs_t regs;
+    // Given each time the flush task completes a frame
+    SemaphoreHandle_t frame_done;
+
+#if OLED_SHADOW_BUFFER
+    // What the controller currently holds in GDDRAM page order, valid only after a full frame has been pushed
+    uint8_t shadow_buffer[OLED_WIDTH * OLED_PAGES];
+    uint8_t shadow_valid;
+#endif
+
+    // Transfer of the front frame in progress, sent one chunk at a time by the flush task.
+    // Windows are in GDDRAM pages.
+    oled_window_t plan[OLED_PLAN_MAX_WINDOWS];
+    uint8_t plan_len;
+    uint8_t plan_full;
+    uint8_t flushing;
+    uint8_t xfer_window;                // Current plan entry
+    uint8_t xfer_page;                  // Next page of the current window to send
+    uint8_t xfer_started;               // Window command of the current window sent
+    uint8_t xfer_failed;                // A transaction of the current frame failed
+    // Columns per GDDRAM page whose transfer failed, sent again with the next frame
+    uint8_t resend_x0[OLED_PAGES];
+    uint8_t resend_x1[OLED_PAGES];
+
+    // Hardware scroll running, GDDRAM pages scroll_page0..scroll_page1 no longer match the front frame
+    uint8_t scrolling;
+    uint8_t scroll_page0;
+    uint8_t scroll_page1;
+
+#if OLED_PORTRAIT_CANVAS
+    // Drawing target while rotated, its dirty tiles are rotated into the back frame on present
+    oled_frame_t canvas;
+    uint8_t rotation;                   // oled_rotation_t
+#endif
+} oled_dev_t;
+
+// Contexts are taken from a static pool, the driver never allocates
+static oled_dev_t g_devices[OLED_MAX_DISPLAYS];
+// Display used by the functions without a handle argument
+static oled_dev_t *g_default;
+
+static TaskHandle_t g_flush_task_handle;
+// Held while the bus is in use, by the flush task or a direct transfer
+static SemaphoreHandle_t g_bus_lock;
+
+#if OLED_GLYPH_CACHE_SLOTS
+/**
+ * One cached glyph in page-major layout: width column bytes for each page of the font height.
+ */
+typedef struct {
+    const font_info_t *font;            // NULL while the slot is free
+    char c;
+    uint8_t width;
+    uint32_t last_used;                 // g_glyph_clock at the last hit, the lowest is evicted
+    uint8_t columns[OLED_GLYPH_CACHE_SLOT_BYTES];
+} oled_glyph_slot_t;
+
+static oled_glyph_slot_t g_glyph_cache[OLED_GLYPH_CACHE_SLOTS];
+static uint32_t g_glyph_clock;
+// Held while a string is drawn, the cache is shared by all displays
+static SemaphoreHandle_t g_glyph_lock;
+#endif
+static oled_glyph_cache_stats_t g_glyph_stats;
+
+static uint32_t oled_send(oled_dev_t *dev, oled_info_type_t info_type, uint8_t register_add, const uint8_t *data, uint32_t data_len);
+static uint32_t oled_send_segments(oled_dev_t *dev, uint8_t register_add, const oled_segment_t *segments, uint32_t segment_count);
+
+// A NULL handle selects the default display
+static inline oled_dev_t *oled_resolve(oled_handle_t handle)
+{
+    return handle ? handle : g_default;
+}
+
+static inline void oled_mark_dirty(oled_frame_t *frame, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1)
+{
+    for (uint8_t page = page0; page <= page1; page++)
+    {
+        if (frame->dirty_x0[page] > frame->dirty_x1[page])
+        {
+            frame->dirty_x0[page] = x0;
+            frame->dirty_x1[page] = x1;
+        }
+        else
+        {
+            if (x0 < frame->dirty_x0[page])
+            {
+                frame->dirty_x0[page] = x0;
+            }
+            if (x1 > frame->dirty_x1[page])
+            {
+                frame->dirty_x1[page] = x1;
+            }
+        }
+    }
+}
+
+static inline void oled_mark_all_dirty(oled_frame_t *frame)
+{
+    memset(frame->dirty_x0, 0, (frame->height >> 3));
+    memset(frame->dirty_x1, (frame->width - 1), (frame->height >> 3));
+}
+
+static inline void oled_mark_all_clean(oled_frame_t *frame)
+{
+    memset(frame->dirty_x0, 0xFF, sizeof(frame->dirty_x0));
+    memset(frame->dirty_x1, 0x00, sizeof(frame->dirty_x1));
+}
+
+// Frame the drawing functions work on: the back frame, or the portrait canvas while rotated
+static inline oled_frame_t *oled_canvas(oled_dev_t *dev)
+{
+#if OLED_PORTRAIT_CANVAS
+    if (dev->rotation != OLED_ROTATION_0)
+    {
+        return &dev->canvas;
+    }
+#endif
+    return dev->back;
+}
+
+// Logical page of a frame stored in GDDRAM page ram_page
+static inline uint8_t oled_ring_page(const oled_frame_t *frame, uint8_t ram_page)
+{
+    return (ram_page + OLED_PAGES - frame->ring) % OLED_PAGES;
+}
+
+static inline void oled_regs_forget_pointer(oled_regs_t *regs)
+{
+    regs->ptr_at_start = 0;
+    regs->ptr_col = OLED_REG_UNKNOWN;
+    regs->ptr_page = OLED_REG_UNKNOWN;
+}
+
+static void oled_flush_begin(oled_dev_t *dev);
+static void oled_flush_step(oled_dev_t *dev);
+static uint32_t oled_scroll_stop(oled_dev_t *dev);
+
+// One scheduling round: every display with work pending sends one chunk, so
+// panels sharing the bus are refreshed side by side and none of them starves.
+// Returns 1 while any display may still have work.
+static uint8_t oled_flush_round()
+{
+    uint8_t busy = 0;
+
+    for (uint8_t i = 0; i < OLED_MAX_DISPLAYS; i++)
+    {
+        oled_dev_t *dev = &g_devices[i];
+        if (!dev->in_use)
+        {
+            continue;
+        }
+
+        xSemaphoreTake(g_bus_lock, portMAX_DELAY);
+        if (!dev->flushing)
+        {
+            oled_flush_begin(dev);
+        }
+        if (dev->flushing)
+        {
+            oled_flush_step(dev);
+            busy = 1;
+        }
+        xSemaphoreGive(g_bus_lock);
+    }
+    return busy;
+}
+
+// Woken on every submit, or by a pacing timer when a frame rate is set
+static void oled_flush_task(void *pvParameter)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (oled_flush_round())
+        {
+        }
+    }
+}
+
+static void oled_pace_timer_callback(void *arg)
+{
+    oled_dev_t *dev = (oled_dev_t *)arg;
+    dev->flush_due = 1;
+    xTaskNotifyGive(g_flush_task_handle);
+}
+
+// Claim the bus for a direct transfer to one display. A frame half way through
+// its transfer to that display is completed first, so its window is not disturbed,
+// and a frame still waiting in the mailbox is sent as well, out of pacing, so it
+// cannot land on the panel after the direct transfer and overwrite it.
+static inline void oled_bus_take(oled_dev_t *dev)
+{
+    xSemaphoreTake(g_bus_lock, portMAX_DELAY);
+    while (dev->flushing)
+    {
+        oled_flush_step(dev);
+    }
+    if (dev->mailbox_full)
+    {
+        dev->flush_due = 1;
+        oled_flush_begin(dev);
+        while (dev->flushing)
+        {
+            oled_flush_step(dev);
+        }
+    }
+}
+
+static inline void oled_bus_give()
+{
+    xSemaphoreGive(g_bus_lock);
+}
+
+static uint32_t oled_init_panel(oled_dev_t *dev)
 {
     uint32_t ret_val = 0;
     uint8_t cmd[] = 
@@ -54,250 +435,2914 @@ uint32_t oled_init(uint32_t (*oled_callback)(oled_info_t *info))
         OLED_DEACTIVATE_SCROLL, 
         OLED_CMD_DISPLAY_ON
     };
-    fire_oled_info = oled_callback;
-    
-    if(oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_CMD_STREAM, cmd, sizeof(cmd)))
+
+    oled_bus_take(dev);
+
+    // Nothing is known about GDDRAM content after reset, first flush pushes everything
+    oled_mark_all_dirty(dev->back);
+    oled_mark_all_clean(dev->mailbox);
+    oled_mark_all_clean(dev->front);
+#if OLED_SHADOW_BUFFER
+    dev->shadow_valid = 0;
+#endif
+    memset(dev->resend_x0, 0xFF, sizeof(dev->resend_x0));
+    memset(dev->resend_x1, 0x00, sizeof(dev->resend_x1));
+    dev->scrolling = 0;
+    dev->panel_ring = 0;
+    memset(&dev->regs, 0xFF, sizeof(dev->regs));
+    oled_regs_forget_pointer(&dev->regs);
+
+    if(oled_send(dev, OLED_SEND_DATA, OLED_CONTROL_BYTE_CMD_STREAM, cmd, sizeof(cmd)))
     {
         oled_debug("Line 68: Oled init error; First initialize communication protocol");
         ret_val = 1;
     }    
+    else
+    {
+        // As set by the init sequence, the address window is left unknown
+        dev->regs.addr_mode = OLED_ADDR_MODE_HORIZONTAL;
+        dev->regs.seg_remap = OLED_CMD_SET_SEGMENT_REMAP;
+        dev->regs.com_scan = OLED_CMD_SET_COM_SCAN_MODE_REMAP;
+        dev->regs.contrast = 0xCF;
+        dev->regs.start_line = OLED_CMD_SET_DISPLAY_START_LINE;
+        dev->regs.display_on = OLED_CMD_DISPLAY_ON;
+        dev->regs.inverse = OLED_CMD_DISPLAY_NORMAL;
+    }
+    oled_bus_give();
     return ret_val;
 }
 
-static uint32_t oled_send(oled_info_type_t info_type, uint8_t  address, uint8_t register_add, uint8_t *data, uint32_t data_len)
+uint32_t oled_create(const oled_config_t *config, oled_handle_t *handle)
 {
-    oled_info_t oled_info;
-    oled_info.info_type = info_type;
-    oled_info.address = address;
-    oled_info.register_add = register_add;
-    oled_info.data = data;
-    oled_info.data_len = data_len;
-    return fire_oled_info(&oled_info);
-}
+    oled_dev_t *dev = NULL;
 
-uint32_t oled_invert_display(uint8_t t)
-{
-    uint32_t ret_val = 0;
-    uint8_t cmd = OLED_CMD_SET_SEGMENT_NORMAL_REMAP;    
-    if(!t)
+    if (config == NULL || config->oled_callback == NULL || handle == NULL)
     {
-        cmd = OLED_CMD_SET_SEGMENT_REMAP;
+        return 1;
     }
-    if(oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_CMD_STREAM, &cmd, 1))
-    {
-        oled_debug("Line 93: Oled invert display error");
-        ret_val = 1;
-    } 
-    return ret_val;
-}
 
-uint32_t oled_reverse_display_scan(uint8_t t)
-{
-    uint32_t ret_val = 0;
-    uint8_t cmd = OLED_CMD_SET_COM_SCAN_MODE_NORMAL;
-    if(!t)
+    if (g_flush_task_handle == NULL)
     {
-        cmd = OLED_CMD_SET_COM_SCAN_MODE_REMAP;
+        g_bus_lock = xSemaphoreCreateMutex();
+#if OLED_GLYPH_CACHE_SLOTS
+        g_glyph_lock = xSemaphoreCreateMutex();
+        if (g_glyph_lock == NULL)
+        {
+            oled_debug("Oled init error; cannot create glyph cache lock");
+            return 1;
+        }
+#endif
+        if (g_bus_lock == NULL ||
+            xTaskCreate(&oled_flush_task, "oled_flush", OLED_FLUSH_TASK_STACK, NULL, OLED_FLUSH_TASK_PRIORITY, &g_flush_task_handle) != pdPASS)
+        {
+            oled_debug("Oled init error; cannot create flush task");
+            return 1;
+        }
     }
-    if(oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_CMD_STREAM, &cmd, 1))
-    {
-        oled_debug("Line 93: Oled reverse display error");
-        ret_val = 1;
-    } 
-    return ret_val;   
-}
-
-void oled_display_text(uint8_t *text, uint32_t text_len) 
-{    
-    uint8_t current_page = 0;
-    uint8_t cmd[] = 
-    {       
-        OLED_CMD_SET_COLUMN_RANGE, 0x00, (OLED_WIDTH - 1),
-        OLED_CMD_SET_PAGE_RANGE, current_page, ((OLED_HEIGHT/8)-1),
-    };    
-    
-    // Initialize display area
-    oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_CMD_STREAM, cmd, sizeof(cmd)); 
 
-    // Optimization: Buffer font data to send larger I2C packets
-    // 64 bytes holds 8 characters (8x8 font), a reasonable chunk size
-    uint8_t buffer[64]; 
-    uint32_t buf_idx = 0;
-
-    for (uint32_t i = 0; i < text_len; i++) 
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < OLED_MAX_DISPLAYS; i++)
     {
-        if (text[i] == '\n') 
+        if (!g_devices[i].in_use)
         {
-            // Flush any pending data in buffer before changing page
-            if (buf_idx > 0)
-            {
-                oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_DATA_STREAM, buffer, buf_idx);
-                buf_idx = 0;
-            }
-
-            if(current_page++ == (OLED_HEIGHT/8))
-            {
-                current_page = 0;
-            }
-            // Update page command
-            cmd[1] = 0x00; // Reset column start
-            cmd[4] = current_page; // Update page start
-            oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_CMD_STREAM, cmd, sizeof(cmd)); 
+            dev = &g_devices[i];
+            dev->in_use = 1;
+            break;
         }
-        else
-        {
-            // Copy font data to buffer
-            memcpy(&buffer[buf_idx], font8x8_basic_tr[(uint8_t)text[i]], 8);
-            buf_idx += 8;
+    }
+    taskEXIT_CRITICAL();
 
-            // If buffer is full, send it
-            if (buf_idx >= sizeof(buffer))
-            {
-                oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_DATA_STREAM, buffer, buf_idx);
-                buf_idx = 0;
-            }
+    if (dev == NULL)
+    {
+        oled_debug("Oled create error; no free display, raise OLED_MAX_DISPLAYS");
+        return 1;
+    }
+
+    if (dev->frame_done == NULL)
+    {
+        dev->frame_done = xSemaphoreCreateBinary();
+        if (dev->frame_done == NULL)
+        {
+            dev->in_use = 0;
+            return 1;
         }
     }
-    
-    // Flush remaining data
-    if (buf_idx > 0)
+    dev->address = config->address;
+    dev->fire_oled_info = config->oled_callback;
+    dev->transport_flags = config->transport_flags;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        dev->frames[i].width = OLED_WIDTH;
+        dev->frames[i].height = OLED_HEIGHT;
+    }
+    dev->back = &dev->frames[0];
+    dev->mailbox = &dev->frames[1];
+    dev->front = &dev->frames[2];
+#if OLED_PORTRAIT_CANVAS
+    dev->canvas.width = OLED_HEIGHT;
+    dev->canvas.height = OLED_WIDTH;
+    dev->rotation = OLED_ROTATION_0;
+    oled_mark_all_clean(&dev->canvas);
+#endif
+    dev->mailbox_full = 0;
+    dev->flushing = 0;
+    dev->submit_seq = 0;
+    dev->done_seq = 0;
+    dev->frame_stats.presented = 0;
+    dev->frame_stats.dropped = 0;
+
+    if (oled_init_panel(dev))
     {
-        oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_DATA_STREAM, buffer, buf_idx);
+        dev->in_use = 0;
+        return 1;
     }
+    *handle = dev;
+    return 0;
 }
 
-static void oled_load_frame(uint8_t buf[])
+uint32_t oled_init(uint32_t (*oled_callback)(oled_info_t *info)) 
 {
-    size_t len = OLED_WIDTH * (OLED_HEIGHT / 8);
-    uint8_t cmd[] = 
-    {       
-        OLED_CMD_SET_COLUMN_RANGE, 0x00, (OLED_WIDTH - 1),
-        OLED_CMD_SET_PAGE_RANGE, 0x00, ((OLED_HEIGHT / 8) - 1), 
-    };    
+    return oled_init_transport(oled_callback, 0);
+}
 
-    oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_CMD_STREAM, cmd, sizeof(cmd));    
-    
-    // Optimization: Use a static zero-buffer for clearing logic to avoid stack overflow
-    // and sending data in larger chunks (OLED_I2C_CHUNK_SIZE)
-    static const uint8_t zero_buf[OLED_I2C_CHUNK_SIZE] = {0}; 
+uint32_t oled_init_transport(uint32_t (*oled_callback)(oled_info_t *info), uint32_t transport_flags) 
+{
+    oled_config_t config = 
+    {
+        .address = OLED_I2C_ADDRESS,
+        .oled_callback = oled_callback,
+        .transport_flags = transport_flags,
+    };
 
-    for (uint32_t i = 0; i < len; i += OLED_I2C_CHUNK_SIZE) 
+    if (g_default != NULL)
     {
-        // Calculate remaining bytes to handle potential uneven sizes (though 1024 is divisible by 128)
-        uint32_t current_chunk_size = (len - i) < OLED_I2C_CHUNK_SIZE ? (len - i) : OLED_I2C_CHUNK_SIZE;
-        
-        oled_send(OLED_SEND_DATA, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_DATA_STREAM, 
-                  buf ? &buf[i] : (uint8_t*)zero_buf, current_chunk_size);
+        // Init again, e.g. after a panel reset
+        g_default->fire_oled_info = oled_callback;
+        g_default->transport_flags = transport_flags;
+        return oled_init_panel(g_default);
     }
-    
-    // Yield only once per frame if needed, rather than per chunk
-    oled_send(OLED_FUNCTION_YEILD, (OLED_I2C_ADDRESS << 1), OLED_CONTROL_BYTE_CMD_STREAM, cmd, sizeof(cmd));
+    return oled_create(&config, &g_default);
 }
 
-void oled_clear_display()
-{   
-    memset(g_frame_buffer, 0, (OLED_WIDTH * (OLED_HEIGHT/8)));   
-    oled_load_frame(g_frame_buffer); 
+static uint32_t oled_send(oled_dev_t *dev, oled_info_type_t info_type, uint8_t register_add, const uint8_t *data, uint32_t data_len)
+{
+    oled_info_t oled_info;
+    oled_info.info_type = info_type;
+    oled_info.address = (dev->address << 1);
+    oled_info.register_add = register_add;
+    oled_info.data = data;
+    oled_info.data_len = data_len;
+    oled_info.segments = NULL;
+    oled_info.segment_count = 0;
+    return dev->fire_oled_info(&oled_info);
 }
 
-void oled_load_xbm(uint8_t *xbm)
+// Send segments as one transaction. For transports without vectored support
+// small segments are coalesced into a staging buffer and large ones are passed through.
+static uint32_t oled_send_segments(oled_dev_t *dev, uint8_t register_add, const oled_segment_t *segments, uint32_t segment_count)
 {
-    uint8_t bit = 0;
-    int32_t row = 0;
-    int32_t column = 0;
-    
-    // Optimization: Simplified pointer arithmetic logic could go here, 
-    // but the main bottleneck is I2C, which is fixed in oled_load_frame.
-    for (row = 0; row < OLED_HEIGHT; row++) 
+    uint32_t ret_val = 0;
+
+    if (dev->transport_flags & OLED_TRANSPORT_SEGMENTS)
     {
-        for (column = 0; column < OLED_WIDTH / 8; column++) 
+        oled_info_t oled_info;
+        oled_info.info_type = OLED_SEND_SEGMENTS;
+        oled_info.address = (dev->address << 1);
+        oled_info.register_add = register_add;
+        oled_info.data = NULL;
+        oled_info.data_len = 0;
+        oled_info.segments = segments;
+        oled_info.segment_count = segment_count;
+        return dev->fire_oled_info(&oled_info);
+    }
+
+    // Only used with the bus lock held
+    static uint8_t staging[OLED_I2C_CHUNK_SIZE];
+    uint32_t staged = 0;
+
+    for (uint32_t i = 0; i < segment_count; i++)
+    {
+        if (staged + segments[i].data_len > sizeof(staging) && staged)
         {
-            uint16_t xbm_offset = row * 16 + column;
-            for (bit = 0; bit < 8; bit++) 
-            {
-                if (*(xbm + xbm_offset) & (1 << bit)) 
-                {
-                    *(g_frame_buffer + OLED_WIDTH * (row / 8) + column * 8 + bit) |= (1 << (row % 8));
-                }
-            }
+            ret_val |= oled_send(dev, OLED_SEND_DATA, register_add, staging, staged);
+            staged = 0;
+        }
+        if (segments[i].data_len > sizeof(staging))
+        {
+            ret_val |= oled_send(dev, OLED_SEND_DATA, register_add, segments[i].data, segments[i].data_len);
+            continue;
         }
+        memcpy(&staging[staged], segments[i].data, segments[i].data_len);
+        staged += segments[i].data_len;
     }
+    if (staged)
+    {
+        ret_val |= oled_send(dev, OLED_SEND_DATA, register_add, staging, staged);
+    }
+    return ret_val;
+}
 
-    oled_load_frame(g_frame_buffer);
+static inline void oled_batch_add(oled_cmd_batch_t *batch, uint8_t byte)
+{
+    batch->buf[batch->len++] = byte;
 }
 
-// Optimization: Marked static inline as it is a helper
-static inline int32_t oled_draw_pixel(uint8_t *fb, int8_t x, int8_t y, oled_color_t color)
+// Send the batched commands as one command stream transaction
+static uint32_t oled_batch_send(oled_dev_t *dev, oled_cmd_batch_t *batch)
 {
-    if ((x >= OLED_WIDTH) || (x < 0) || (y >= OLED_HEIGHT) || (y < 0))
+    uint32_t ret_val = 0;
+    if (batch->len)
     {
-        return -1;
+        ret_val = oled_send(dev, OLED_SEND_DATA, OLED_CONTROL_BYTE_CMD_STREAM, batch->buf, batch->len);
+        if (ret_val)
+        {
+            // Whatever part of it arrived is unknown now
+            memset(&dev->regs, 0xFF, sizeof(dev->regs));
+            oled_regs_forget_pointer(&dev->regs);
+        }
+        batch->len = 0;
+    }
+    return ret_val;
+}
+
+// Single byte command, skipped when the register already holds it
+static inline void oled_cmd_byte(oled_cmd_batch_t *batch, uint16_t *reg, uint8_t cmd)
+{
+    if (*reg != cmd)
+    {
+        oled_batch_add(batch, cmd);
+        *reg = cmd;
     }
+}
 
-    uint16_t index = x + (y / 8) * OLED_WIDTH;
-    
-    if (color == OLED_COLOR_WHITE) {
-        fb[index] |= (1 << (y & 7));
-    } else {
-        fb[index] &= ~(1 << (y & 7));
+// Command with one parameter, skipped when the register already holds the value
+static inline void oled_cmd_param(oled_cmd_batch_t *batch, uint16_t *reg, uint8_t cmd, uint8_t value)
+{
+    if (*reg != value)
+    {
+        oled_batch_add(batch, cmd);
+        oled_batch_add(batch, value);
+        *reg = value;
     }
-    return 0;
 }
 
-int32_t oled_prepare_string_frame(const font_info_t *font, uint8_t x, uint8_t y, const char *str, oled_color_t foreground, oled_color_t background)
+// Point the horizontal address window at x0..x1, page0..page1.
+// A range command also moves the pointer to its start, so a range that is
+// already set is only repeated when the pointer has moved away from its start.
+static void oled_cmd_window(oled_dev_t *dev, oled_cmd_batch_t *batch, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1)
 {
-    uint8_t t = x;
-    int err;
+    oled_regs_t *regs = &dev->regs;
 
-    if (font == NULL || str == NULL)
+    if (regs->addr_mode != OLED_ADDR_MODE_HORIZONTAL)
     {
-        return 0;
+        oled_regs_forget_pointer(regs);
     }
+    uint8_t at_start = regs->ptr_at_start;
 
-    while (*str) 
+    oled_cmd_param(batch, &regs->addr_mode, OLED_CMD_SET_MEMORY_ADDR_MODE, OLED_ADDR_MODE_HORIZONTAL);
+    if (!at_start || regs->col0 != x0 || regs->col1 != x1)
     {
-        // Helper function to draw individual characters (internal)
-        // Note: We replicate the draw logic here or wrap the original draw_char
-        // For simplicity, we keep the original logic flow calling a helper
-        const font_char_desc_t *d = font_get_char_desc(font, *str);
-        if (d != NULL)
-        {
-             const uint8_t *bitmap = font->bitmap + d->offset;
-             for (uint8_t j = 0; j < font->height; ++j) 
-             {
-                 for (uint8_t i = 0; i < d->width; ++i) 
-                 {
-                     uint8_t line = 0;
-                     if (i % 8 == 0) 
-                     {
-                         line = bitmap[(d->width + 7) / 8 * j + i / 8];
-                     }
-                     
-                     // Optimization: bit check directly
-                     if (line & (0x80 >> (i % 8))) 
-                     {
-                         oled_draw_pixel(g_frame_buffer, x + i, y + j, foreground);
-                     }
-                     else 
-                     {
-                         oled_draw_pixel(g_frame_buffer, x + i, y + j, background);
-                     }
-                 }
-             }
-             x += d->width;
+        oled_batch_add(batch, OLED_CMD_SET_COLUMN_RANGE);
+        oled_batch_add(batch, x0);
+        oled_batch_add(batch, x1);
+        regs->col0 = x0;
+        regs->col1 = x1;
+    }
+    if (!at_start || regs->page0 != page0 || regs->page1 != page1)
+    {
+        oled_batch_add(batch, OLED_CMD_SET_PAGE_RANGE);
+        oled_batch_add(batch, page0);
+        oled_batch_add(batch, page1);
+        regs->page0 = page0;
+        regs->page1 = page1;
+    }
+    regs->ptr_at_start = 1;
+}
+
+// Move the pointer to column x0 of page in page addressing mode, only the parts that differ are sent
+static void oled_cmd_page_window(oled_dev_t *dev, oled_cmd_batch_t *batch, uint8_t x0, uint8_t page)
+{
+    oled_regs_t *regs = &dev->regs;
+
+    if (regs->addr_mode != OLED_ADDR_MODE_PAGE)
+    {
+        oled_regs_forget_pointer(regs);
+    }
+    oled_cmd_param(batch, &regs->addr_mode, OLED_CMD_SET_MEMORY_ADDR_MODE, OLED_ADDR_MODE_PAGE);
+    if (regs->ptr_page != page)
+    {
+        oled_batch_add(batch, OLED_CMD_SET_PAGE_START | page);
+        regs->ptr_page = page;
+    }
+    if (regs->ptr_col == OLED_REG_UNKNOWN || ((regs->ptr_col ^ x0) & 0x0F))
+    {
+        oled_batch_add(batch, OLED_CMD_SET_LOWER_COLUMN | (x0 & 0x0F));
+    }
+    if (regs->ptr_col == OLED_REG_UNKNOWN || ((regs->ptr_col ^ x0) & 0xF0))
+    {
+        oled_batch_add(batch, OLED_CMD_SET_HIGHER_COLUMN | (x0 >> 4));
+    }
+    regs->ptr_col = x0;
+}
+
+static inline uint8_t oled_window_page_mode(const oled_window_t *window)
+{
+    return (OLED_PAGE_ADDRESSING && window->page0 == window->page1);
+}
+
+uint32_t oled_invert_display_h(oled_handle_t handle, uint8_t t)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_cmd_batch_t batch = { .len = 0 };
+    uint32_t ret_val = 0;
+    uint8_t cmd = OLED_CMD_SET_SEGMENT_NORMAL_REMAP;    
+    if(!t)
+    {
+        cmd = OLED_CMD_SET_SEGMENT_REMAP;
+    }
+    oled_bus_take(dev);
+    oled_cmd_byte(&batch, &dev->regs.seg_remap, cmd);
+    if(oled_batch_send(dev, &batch))
+    {
+        oled_debug("Line 93: Oled invert display error");
+        ret_val = 1;
+    } 
+    oled_bus_give();
+    return ret_val;
+}
+
+uint32_t oled_invert_display(uint8_t t)
+{
+    return oled_invert_display_h(NULL, t);
+}
+
+uint32_t oled_reverse_display_scan_h(oled_handle_t handle, uint8_t t)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_cmd_batch_t batch = { .len = 0 };
+    uint32_t ret_val = 0;
+    uint8_t cmd = OLED_CMD_SET_COM_SCAN_MODE_NORMAL;
+    if(!t)
+    {
+        cmd = OLED_CMD_SET_COM_SCAN_MODE_REMAP;
+    }
+    oled_bus_take(dev);
+    oled_cmd_byte(&batch, &dev->regs.com_scan, cmd);
+    if(oled_batch_send(dev, &batch))
+    {
+        oled_debug("Line 93: Oled reverse display error");
+        ret_val = 1;
+    } 
+    oled_bus_give();
+    return ret_val;   
+}
+
+uint32_t oled_reverse_display_scan(uint8_t t)
+{
+    return oled_reverse_display_scan_h(NULL, t);
+}
+
+// Glyphs move the GDDRAM pointer away from the start of the window
+static void oled_send_glyphs(oled_dev_t *dev, const oled_segment_t *glyphs, uint32_t glyph_count)
+{
+    oled_send_segments(dev, OLED_CONTROL_BYTE_DATA_STREAM, glyphs, glyph_count);
+    dev->regs.ptr_at_start = 0;
+}
+
+uint32_t oled_set_contrast(oled_handle_t handle, uint8_t contrast)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_cmd_batch_t batch = { .len = 0 };
+    uint32_t ret_val = 0;
+
+    oled_bus_take(dev);
+    oled_cmd_param(&batch, &dev->regs.contrast, OLED_CMD_SET_CONTRAST, contrast);
+    if (oled_batch_send(dev, &batch))
+    {
+        oled_debug("Oled set contrast error");
+        ret_val = 1;
+    }
+    oled_bus_give();
+    return ret_val;
+}
+
+uint32_t oled_set_display_on(oled_handle_t handle, uint8_t on)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_cmd_batch_t batch = { .len = 0 };
+    uint32_t ret_val = 0;
+
+    oled_bus_take(dev);
+    oled_cmd_byte(&batch, &dev->regs.display_on, on ? OLED_CMD_DISPLAY_ON : OLED_CMD_DISPLAY_OFF);
+    if (oled_batch_send(dev, &batch))
+    {
+        oled_debug("Oled display on/off error");
+        ret_val = 1;
+    }
+    oled_bus_give();
+    return ret_val;
+}
+
+uint32_t oled_set_inverse(oled_handle_t handle, uint8_t inverse)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_cmd_batch_t batch = { .len = 0 };
+    uint32_t ret_val = 0;
+
+    oled_bus_take(dev);
+    oled_cmd_byte(&batch, &dev->regs.inverse, inverse ? OLED_CMD_DISPLAY_INVERTED : OLED_CMD_DISPLAY_NORMAL);
+    if (oled_batch_send(dev, &batch))
+    {
+        oled_debug("Oled inverse error");
+        ret_val = 1;
+    }
+    oled_bus_give();
+    return ret_val;
+}
+
+void oled_display_text_h(oled_handle_t handle, uint8_t *text, uint32_t text_len) 
+{    
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_cmd_batch_t batch = { .len = 0 };
+    uint8_t current_page = 0;
+    
+    oled_bus_take(dev);
+
+    // Text is written straight into GDDRAM, which must not happen while it scrolls
+    if (dev->scrolling)
+    {
+        oled_scroll_stop(dev);
+    }
+
+    // Initialize display area
+    oled_cmd_window(dev, &batch, 0x00, (OLED_WIDTH - 1), dev->panel_ring, ((OLED_HEIGHT/8)-1));
+    oled_batch_send(dev, &batch);
+
+    // Glyph columns are sent straight out of the font table, 
+    // up to OLED_MAX_SEGMENTS characters per transaction
+    oled_segment_t glyphs[OLED_MAX_SEGMENTS];
+    uint32_t glyph_count = 0;
+
+    for (uint32_t i = 0; i < text_len; i++) 
+    {
+        if (text[i] == '\n') 
+        {
+            // Flush any pending glyphs before changing page
+            if (glyph_count > 0)
+            {
+                oled_send_glyphs(dev, glyphs, glyph_count);
+                glyph_count = 0;
+            }
+
+            if(current_page++ == (OLED_HEIGHT/8))
+            {
+                current_page = 0;
+            }
+            // Column start back to 0, page start through the ring
+            oled_cmd_window(dev, &batch, 0x00, (OLED_WIDTH - 1), (current_page + dev->panel_ring) % OLED_PAGES, ((OLED_HEIGHT/8)-1));
+            oled_batch_send(dev, &batch);
+        }
+        else
+        {
+            glyphs[glyph_count].data = font8x8_basic_tr[(uint8_t)text[i]];
+            glyphs[glyph_count].data_len = sizeof(font8x8_basic_tr[0]);
+            glyph_count++;
+
+            if (glyph_count == OLED_MAX_SEGMENTS)
+            {
+                oled_send_glyphs(dev, glyphs, glyph_count);
+                glyph_count = 0;
+            }
+        }
+    }
+    
+    // Flush remaining glyphs
+    if (glyph_count > 0)
+    {
+        oled_send_glyphs(dev, glyphs, glyph_count);
+    }
+
+    // GDDRAM no longer matches the frame buffer, next flush has to rewrite all of it
+    taskENTER_CRITICAL();
+    oled_mark_all_dirty(dev->mailbox);
+    taskEXIT_CRITICAL();
+    oled_mark_all_dirty(dev->back);
+#if OLED_SHADOW_BUFFER
+    dev->shadow_valid = 0;
+#endif
+    oled_bus_give();
+}
+
+void oled_display_text(uint8_t *text, uint32_t text_len) 
+{
+    oled_display_text_h(NULL, text, text_len);
+}
+
+/**
+ * Decoder state of a run/literal packed stream, runs and literals may continue
+ * from one output chunk into the next.
+ */
+typedef struct {
+    const uint8_t *data;
+    const uint8_t *end;
+    uint8_t count;                      // Bytes left in the current run or literal
+    uint8_t literal;
+    uint8_t value;                      // Byte repeated by the current run
+} oled_unpack_t;
+
+// Decode the next len bytes, returns 1 when the stream ends early
+static uint32_t oled_unpack(oled_unpack_t *unpack, uint8_t *out, uint16_t len)
+{
+    while (len)
+    {
+        if (unpack->count == 0)
+        {
+            if (unpack->data >= unpack->end)
+            {
+                return 1;
+            }
+            uint8_t control = *unpack->data++;
+            if (control & 0x80)
+            {
+                if (unpack->data >= unpack->end)
+                {
+                    return 1;
+                }
+                unpack->count = (control & 0x7F) + OLED_PACKED_MIN_RUN;
+                unpack->literal = 0;
+                unpack->value = *unpack->data++;
+            }
+            else
+            {
+                unpack->count = control + 1;
+                unpack->literal = 1;
+            }
+        }
+
+        uint8_t n = (unpack->count < len) ? unpack->count : len;
+        if (unpack->literal)
+        {
+            if (unpack->end - unpack->data < n)
+            {
+                return 1;
+            }
+            memcpy(out, unpack->data, n);
+            unpack->data += n;
+        }
+        else
+        {
+            memset(out, unpack->value, n);
+        }
+        out += n;
+        len -= n;
+        unpack->count -= n;
+    }
+    return 0;
+}
+
+uint32_t oled_show_packed_image(oled_handle_t handle, const oled_packed_image_t *image)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    uint8_t chunk[OLED_I2C_CHUNK_SIZE];
+    uint32_t ret_val = 0;
+
+    if (image == NULL || image->data == NULL || image->width == 0 || image->pages == 0 ||
+        image->x + image->width > OLED_WIDTH || image->page + image->pages > OLED_PAGES)
+    {
+        return 1;
+    }
+
+    oled_unpack_t unpack = { image->data, image->data + image->data_len, 0, 0, 0 };
+    uint8_t x1 = image->x + image->width - 1;
+    uint8_t page = image->page;
+    uint8_t last = image->page + image->pages - 1;
+
+    oled_bus_take(dev);
+
+    // The image is written straight into GDDRAM, which must not happen while it scrolls
+    if (dev->scrolling)
+    {
+        oled_scroll_stop(dev);
+    }
+
+    while (page <= last && ret_val == 0)
+    {
+        // One window per stretch of pages that does not wrap around the GDDRAM ring
+        uint8_t ram_page = (page + dev->panel_ring) % OLED_PAGES;
+        uint8_t count = (last - page + 1 < OLED_PAGES - ram_page) ? (last - page + 1) : (OLED_PAGES - ram_page);
+        uint16_t offset = 0;
+        oled_cmd_batch_t batch = { .len = 0 };
+
+        oled_cmd_window(dev, &batch, image->x, x1, ram_page, ram_page + count - 1);
+        ret_val = oled_batch_send(dev, &batch);
+        dev->regs.ptr_at_start = 0;
+
+        // Decoded straight into transport sized chunks
+        while (ret_val == 0 && offset < image->width * count)
+        {
+            uint16_t len = image->width * count - offset;
+            len = (len < sizeof(chunk)) ? len : sizeof(chunk);
+            ret_val = oled_unpack(&unpack, chunk, len);
+            if (ret_val == 0)
+            {
+                ret_val = oled_send(dev, OLED_SEND_DATA, OLED_CONTROL_BYTE_DATA_STREAM, chunk, len);
+            }
+            if (ret_val)
+            {
+                break;
+            }
+
+            // Keep the frame buffer and the GDDRAM shadow in step with the panel, so the image
+            // is neither sent again nor lost when the next frame is drawn on top of it
+            for (uint16_t done = 0; done < len; )
+            {
+                uint8_t row = (offset + done) / image->width;
+                uint8_t column = (offset + done) % image->width;
+                uint8_t n = ((image->width - column) < (len - done)) ? (image->width - column) : (len - done);
+
+                memcpy(&dev->back->buffer[OLED_WIDTH * (page + row) + image->x + column], &chunk[done], n);
+#if OLED_SHADOW_BUFFER
+                memcpy(&dev->shadow_buffer[OLED_WIDTH * (ram_page + row) + image->x + column], &chunk[done], n);
+#endif
+                done += n;
+            }
+            offset += len;
+        }
+        // A complete window leaves the pointer back at its start
+        dev->regs.ptr_at_start = (ret_val == 0);
+        page += count;
+    }
+
+    if (ret_val)
+    {
+        oled_debug("Oled packed image error; stream ended early or transfer failed");
+        oled_regs_forget_pointer(&dev->regs);
+    }
+    oled_bus_give();
+    return ret_val;
+}
+
+uint32_t oled_anim_start(oled_handle_t handle, oled_anim_player_t *player, const oled_anim_t *anim)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = dev->back;
+
+    if (player == NULL)
+    {
+        return 1;
+    }
+    player->anim = NULL;
+    if (anim == NULL || anim->keyframe == NULL || anim->deltas == NULL || 
+        anim->width == 0 || anim->pages == 0 || anim->frame_count == 0 ||
+        anim->x + anim->width > OLED_WIDTH || anim->page + anim->pages > OLED_PAGES)
+    {
+        return 1;
+    }
+
+    // The keyframe goes through the frame buffer, so it is paced and diffed like any other frame
+    oled_unpack_t unpack = { anim->keyframe, anim->keyframe + anim->keyframe_len, 0, 0, 0 };
+    for (uint8_t page = anim->page; page < anim->page + anim->pages; page++)
+    {
+        if (oled_unpack(&unpack, &frame->buffer[OLED_WIDTH * page + anim->x], anim->width))
+        {
+            oled_debug("Oled animation error; keyframe ended early");
+            return 1;
+        }
+    }
+    oled_mark_dirty(frame, anim->x, anim->x + anim->width - 1, anim->page, anim->page + anim->pages - 1);
+
+    player->anim = anim;
+    player->frame = 0;
+    player->offset = 0;
+    oled_display_prepared_frame_h(dev);
+    return 0;
+}
+
+uint32_t oled_anim_next(oled_handle_t handle, oled_anim_player_t *player)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = dev->back;
+
+    // Not started, or oled_anim_start() failed
+    if (player == NULL || player->anim == NULL)
+    {
+        return 1;
+    }
+
+    const oled_anim_t *anim = player->anim;
+    const uint8_t *data = anim->deltas + player->offset;
+    const uint8_t *end = anim->deltas + anim->deltas_len;
+
+    // Each run is copied into the back frame and marked dirty on its own page only,
+    // the shadow diff then sends the changed bytes of each page
+    while (1)
+    {
+        if (data >= end)
+        {
+            oled_debug("Oled animation error; delta %u ended early", player->frame);
+            return 1;
+        }
+        uint8_t page = *data++;
+        if (page == OLED_ANIM_DELTA_END)
+        {
+            break;
+        }
+        if (end - data < 2)
+        {
+            oled_debug("Oled animation error; delta %u ended early", player->frame);
+            return 1;
+        }
+        uint8_t x = *data++;
+        uint16_t len = *data++ + 1;
+        if (page >= anim->pages || x + len > anim->width || end - data < len)
+        {
+            oled_debug("Oled animation error; bad run in delta %u", player->frame);
+            return 1;
+        }
+
+        page += anim->page;
+        x += anim->x;
+        memcpy(&frame->buffer[OLED_WIDTH * page + x], data, len);
+        oled_mark_dirty(frame, x, x + len - 1, page, page);
+        data += len;
+    }
+
+    if (++player->frame == anim->frame_count)
+    {
+        player->frame = 0;
+        player->offset = 0;
+    }
+    else
+    {
+        player->offset = data - anim->deltas;
+    }
+    oled_display_prepared_frame_h(dev);
+    return 0;
+}
+
+// Append a window to the transfer plan, returns 1 when the plan is full.
+// A window directly below one with the same columns extends it instead,
+// which only costs another data transaction, but the window then needs the
+// horizontal mode range commands.
+static uint8_t oled_plan_add(oled_dev_t *dev, uint8_t x0, uint8_t x1, uint8_t page, uint32_t *cost)
+{
+    oled_window_t *last = dev->plan_len ? &dev->plan[dev->plan_len - 1] : NULL;
+
+    if (last && last->page1 == (page - 1) && last->x0 == x0 && last->x1 == x1)
+    {
+        if (last->page0 == last->page1)
+        {
+            *cost += OLED_XFER_WINDOW_COST - OLED_XFER_PAGE_WINDOW_COST;
+        }
+        last->page1 = page;
+        *cost += OLED_XFER_TXN_COST + (x1 - x0 + 1);
+        return 0;
+    }
+    if (dev->plan_len == OLED_PLAN_MAX_WINDOWS)
+    {
+        return 1;
+    }
+
+    dev->plan[dev->plan_len].x0 = x0;
+    dev->plan[dev->plan_len].x1 = x1;
+    dev->plan[dev->plan_len].page0 = page;
+    dev->plan[dev->plan_len].page1 = page;
+    dev->plan_len++;
+    *cost += OLED_XFER_PAGE_WINDOW_COST + (x1 - x0 + 1);
+    return 0;
+}
+
+// Build the list of windows to send for the dirty pages of the front frame.
+// With a valid shadow only the changed byte runs of each dirty window are kept,
+// and two runs are merged when resending the unchanged gap between them is
+// cheaper than opening another window.
+// Returns 1 when one full frame push is estimated to be cheaper than the plan.
+static uint8_t oled_plan_frame(oled_dev_t *dev)
+{
+    const oled_frame_t *frame = dev->front;
+    uint32_t cost = 0;
+    dev->plan_len = 0;
+
+    // Walk GDDRAM pages, so windows never wrap around the ring
+    for (uint8_t ram_page = 0; ram_page < OLED_PAGES; ram_page++)
+    {
+        uint8_t page = oled_ring_page(frame, ram_page);
+        if (frame->dirty_x0[page] > frame->dirty_x1[page])
+        {
+            continue;
+        }
+
+#if OLED_SHADOW_BUFFER
+        if (dev->shadow_valid)
+        {
+            const uint8_t *fb = &frame->buffer[OLED_WIDTH * page];
+            const uint8_t *shadow = &dev->shadow_buffer[OLED_WIDTH * ram_page];
+            int16_t run_start = -1;
+            int16_t run_end = -1;
+
+            for (int16_t x = frame->dirty_x0[page]; x <= frame->dirty_x1[page]; x++)
+            {
+                if (fb[x] == shadow[x])
+                {
+                    continue;
+                }
+                if (run_start >= 0 && (x - run_end - 1) <= OLED_XFER_PAGE_WINDOW_COST)
+                {
+                    run_end = x;
+                    continue;
+                }
+                if (run_start >= 0 && oled_plan_add(dev, run_start, run_end, ram_page, &cost))
+                {
+                    return 1;
+                }
+                run_start = x;
+                run_end = x;
+            }
+            if (run_start >= 0 && oled_plan_add(dev, run_start, run_end, ram_page, &cost))
+            {
+                return 1;
+            }
+            continue;
+        }
+#endif
+        if (oled_plan_add(dev, frame->dirty_x0[page], frame->dirty_x1[page], ram_page, &cost))
+        {
+            return 1;
+        }
+    }
+
+    return (cost >= OLED_XFER_FULL_FRAME_COST);
+}
+
+static void oled_flush_finish(oled_dev_t *dev)
+{
+#if OLED_SHADOW_BUFFER
+    if (dev->plan_full && !dev->xfer_failed)
+    {
+        dev->shadow_valid = 1;
+    }
+#endif
+    oled_mark_all_clean(dev->front);
+    dev->flushing = 0;
+
+    // Scrolling the ring costs one command byte, sent once the exposed pages are in place.
+    // A start line lost to a failed command batch is sent again with the next frame.
+    if (dev->front->ring != dev->panel_ring || dev->regs.start_line == OLED_REG_UNKNOWN)
+    {
+        oled_cmd_batch_t batch = { .len = 0 };
+        oled_cmd_byte(&batch, &dev->regs.start_line, OLED_CMD_SET_DISPLAY_START_LINE | (dev->front->ring * 8));
+        oled_batch_send(dev, &batch);
+        dev->panel_ring = dev->front->ring;
+    }
+
+    // Yield only once per frame if needed, rather than per chunk
+    if (dev->plan_len)
+    {
+        oled_send(dev, OLED_FUNCTION_YEILD, OLED_CONTROL_BYTE_CMD_STREAM, NULL, 0);
+    }
+
+    dev->frame_stats.presented++;
+    dev->done_seq = dev->front->seq;
+    xSemaphoreGive(dev->frame_done);
+}
+
+static inline void oled_xfer_begin(oled_dev_t *dev)
+{
+    dev->xfer_window = 0;
+    dev->xfer_page = dev->plan[0].page0;
+    dev->xfer_started = 0;
+    dev->xfer_failed = 0;
+}
+
+// Part of a window did not reach the panel. What GDDRAM holds there is unknown,
+// so the shadow is dropped and the columns are sent again with the next frame.
+static void oled_xfer_failed(oled_dev_t *dev, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1)
+{
+#if OLED_SHADOW_BUFFER
+    dev->shadow_valid = 0;
+#endif
+    dev->xfer_failed = 1;
+    oled_regs_forget_pointer(&dev->regs);
+    for (uint8_t page = page0; page <= page1; page++)
+    {
+        if (dev->resend_x0[page] > dev->resend_x1[page])
+        {
+            dev->resend_x0[page] = x0;
+            dev->resend_x1[page] = x1;
+        }
+        else
+        {
+            dev->resend_x0[page] = (x0 < dev->resend_x0[page]) ? x0 : dev->resend_x0[page];
+            dev->resend_x1[page] = (x1 > dev->resend_x1[page]) ? x1 : dev->resend_x1[page];
+        }
+    }
+}
+
+// Take the latest submitted frame into the front slot and plan its transfer.
+// With pacing on this only happens once per timer period.
+static void oled_flush_begin(oled_dev_t *dev)
+{
+    // GDDRAM is not written while the controller scrolls it, frames wait for oled_stop_scroll()
+    if (dev->scrolling)
+    {
+        return;
+    }
+    if (dev->frame_rate && !dev->flush_due)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    uint8_t take = dev->mailbox_full;
+    if (take)
+    {
+        oled_frame_t *frame = dev->mailbox;
+        dev->mailbox = dev->front;
+        dev->front = frame;
+        dev->mailbox_full = 0;
+    }
+    dev->flush_due = 0;
+    taskEXIT_CRITICAL();
+
+    if (!take)
+    {
+        return;
+    }
+
+    // Columns a failed transfer left behind go out with this frame
+    for (uint8_t ram_page = 0; ram_page < OLED_PAGES; ram_page++)
+    {
+        if (dev->resend_x0[ram_page] <= dev->resend_x1[ram_page])
+        {
+            uint8_t page = oled_ring_page(dev->front, ram_page);
+            oled_mark_dirty(dev->front, dev->resend_x0[ram_page], dev->resend_x1[ram_page], page, page);
+        }
+    }
+    memset(dev->resend_x0, 0xFF, sizeof(dev->resend_x0));
+    memset(dev->resend_x1, 0x00, sizeof(dev->resend_x1));
+
+    dev->plan_full = oled_plan_frame(dev);
+    if (dev->plan_full)
+    {
+        dev->plan[0].x0 = 0;
+        dev->plan[0].x1 = (OLED_WIDTH - 1);
+        dev->plan[0].page0 = 0;
+        dev->plan[0].page1 = (OLED_PAGES - 1);
+        dev->plan_len = 1;
+    }
+    oled_xfer_begin(dev);
+    dev->flushing = 1;
+
+    if (dev->plan_len == 0)
+    {
+        oled_flush_finish(dev);
+    }
+}
+
+// Move on to the next window of the plan, returns 1 when the last one is done
+static uint8_t oled_xfer_next_window(oled_dev_t *dev)
+{
+    dev->xfer_window++;
+    if (dev->xfer_window == dev->plan_len)
+    {
+        return 1;
+    }
+    dev->xfer_page = dev->plan[dev->xfer_window].page0;
+    dev->xfer_started = 0;
+    return 0;
+}
+
+// Send the next piece of the planned transfer: the window command when a window
+// starts, then one data transaction of up to OLED_I2C_CHUNK_SIZE bytes.
+// The window wraps at x1, so each page is one run of the front frame.
+// Returns 1 once the last window has been sent.
+static uint8_t oled_xfer_step(oled_dev_t *dev)
+{
+    const oled_window_t *window = &dev->plan[dev->xfer_window];
+    uint8_t width = (window->x1 - window->x0 + 1);
+
+    if (!dev->xfer_started)
+    {
+        oled_cmd_batch_t batch = { .len = 0 };
+        if (oled_window_page_mode(window))
+        {
+            oled_cmd_page_window(dev, &batch, window->x0, window->page0);
+        }
+        else
+        {
+            oled_cmd_window(dev, &batch, window->x0, window->x1, window->page0, window->page1);
+        }
+        dev->xfer_started = 1;
+        if (oled_batch_send(dev, &batch))
+        {
+            // Data sent now would land wherever the pointer happens to be, the window is skipped
+            oled_xfer_failed(dev, window->x0, window->x1, window->page0, window->page1);
+            dev->xfer_page = window->page1 + 1;
+            return oled_xfer_next_window(dev);
+        }
+        dev->regs.ptr_at_start = 0;
+    }
+
+    oled_segment_t runs[OLED_PAGES];
+    uint32_t run_count = 0;
+    uint32_t chunk_len = 0;
+    uint8_t page = dev->xfer_page;
+
+    while (page <= window->page1 && (run_count == 0 || chunk_len + width <= OLED_I2C_CHUNK_SIZE))
+    {
+        runs[run_count].data = &dev->front->buffer[OLED_WIDTH * oled_ring_page(dev->front, page) + window->x0];
+        runs[run_count].data_len = width;
+        run_count++;
+        chunk_len += width;
+        page++;
+    }
+    if (oled_send_segments(dev, OLED_CONTROL_BYTE_DATA_STREAM, runs, run_count))
+    {
+        // How much of the chunk arrived is unknown, the rest of the window is skipped as well
+        oled_xfer_failed(dev, window->x0, window->x1, dev->xfer_page, window->page1);
+        dev->xfer_page = window->page1 + 1;
+        return oled_xfer_next_window(dev);
+    }
+
+#if OLED_SHADOW_BUFFER
+    for (uint8_t p = dev->xfer_page; p < page; p++)
+    {
+        memcpy(&dev->shadow_buffer[OLED_WIDTH * p + window->x0], 
+               &dev->front->buffer[OLED_WIDTH * oled_ring_page(dev->front, p) + window->x0], width);
+    }
+#endif
+    dev->xfer_page = page;
+
+    if (page > window->page1)
+    {
+        if (oled_window_page_mode(window))
+        {
+            // Page mode keeps going right, where it wraps to is not known
+            dev->regs.ptr_col = (window->x1 < (OLED_WIDTH - 1)) ? (window->x1 + 1) : OLED_REG_UNKNOWN;
+        }
+        else
+        {
+            // The whole window has been written, the pointer wrapped back to its start
+            dev->regs.ptr_at_start = 1;
+        }
+        return oled_xfer_next_window(dev);
+    }
+    return 0;
+}
+
+static void oled_flush_step(oled_dev_t *dev)
+{
+    if (oled_xfer_step(dev))
+    {
+        oled_flush_finish(dev);
+    }
+}
+
+// Stop the scroll and write the front frame over the scrolled pages, the bus is held by the caller
+static uint32_t oled_scroll_stop(oled_dev_t *dev)
+{
+    oled_cmd_batch_t batch = { .len = 0 };
+
+    oled_batch_add(&batch, OLED_DEACTIVATE_SCROLL);
+    oled_cmd_byte(&batch, &dev->regs.start_line, OLED_CMD_SET_DISPLAY_START_LINE | (dev->panel_ring * 8));
+    if (oled_batch_send(dev, &batch))
+    {
+        oled_debug("Oled stop scroll error");
+        return 1;
+    }
+    dev->scrolling = 0;
+
+    // The scrolled GDDRAM content is left behind at some offset, resend those pages
+    dev->plan[0].x0 = 0;
+    dev->plan[0].x1 = (OLED_WIDTH - 1);
+    dev->plan[0].page0 = dev->scroll_page0;
+    dev->plan[0].page1 = dev->scroll_page1;
+    dev->plan_len = 1;
+    oled_xfer_begin(dev);
+    while (!oled_xfer_step(dev))
+    {
+    }
+    return 0;
+}
+
+static uint32_t oled_scroll_start(oled_dev_t *dev, const uint8_t *cmd, uint32_t cmd_len, uint8_t page0, uint8_t page1)
+{
+    uint32_t ret_val = 0;
+
+    oled_bus_take(dev);
+    if (dev->scrolling)
+    {
+        oled_scroll_stop(dev);
+    }
+    if (oled_send(dev, OLED_SEND_DATA, OLED_CONTROL_BYTE_CMD_STREAM, cmd, cmd_len))
+    {
+        oled_debug("Oled start scroll error");
+        ret_val = 1;
+    }
+    else
+    {
+        dev->scrolling = 1;
+        dev->scroll_page0 = page0;
+        dev->scroll_page1 = page1;
+        // A vertical scroll moves the start line, it is set again when the scroll stops
+        dev->regs.start_line = OLED_REG_UNKNOWN;
+        oled_regs_forget_pointer(&dev->regs);
+    }
+    oled_bus_give();
+    return ret_val;
+}
+
+// Map a screen page range to the GDDRAM pages the controller scrolls. All pages stay 0..7 whatever the ring,
+// any other range must not wrap around the ring.
+static uint32_t oled_scroll_pages(oled_dev_t *dev, uint8_t *page0, uint8_t *page1)
+{
+    if (*page0 > *page1 || *page1 >= OLED_PAGES)
+    {
+        return 1;
+    }
+    if ((*page1 - *page0) == (OLED_PAGES - 1))
+    {
+        return 0;
+    }
+    *page0 = (*page0 + dev->panel_ring) % OLED_PAGES;
+    *page1 = (*page1 + dev->panel_ring) % OLED_PAGES;
+    return (*page0 > *page1) ? 1 : 0;
+}
+
+uint32_t oled_start_scroll(oled_handle_t handle, oled_scroll_dir_t dir, uint8_t page0, uint8_t page1, oled_scroll_speed_t speed)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+
+    if (oled_scroll_pages(dev, &page0, &page1))
+    {
+        return 1;
+    }
+
+    uint8_t cmd[] = 
+    {
+        OLED_DEACTIVATE_SCROLL,
+        (dir == OLED_SCROLL_LEFT) ? OLED_CMD_SCROLL_LEFT : OLED_CMD_SCROLL_RIGHT,
+        0x00, page0, speed, page1, 0x00, 0xFF,
+        OLED_ACTIVATE_SCROLL,
+    };
+    return oled_scroll_start(dev, cmd, sizeof(cmd), page0, page1);
+}
+
+uint32_t oled_start_diagonal_scroll(oled_handle_t handle, oled_scroll_dir_t dir, uint8_t page0, uint8_t page1, oled_scroll_speed_t speed,
+                                    uint8_t vertical_offset, uint8_t area_top, uint8_t area_rows)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+
+    if (vertical_offset >= OLED_HEIGHT || (area_top + area_rows) > OLED_HEIGHT || vertical_offset >= area_rows ||
+        oled_scroll_pages(dev, &page0, &page1))
+    {
+        return 1;
+    }
+
+    uint8_t cmd[] = 
+    {
+        OLED_DEACTIVATE_SCROLL,
+        OLED_CMD_SET_VERTICAL_SCROLL_AREA, area_top, area_rows,
+        (dir == OLED_SCROLL_LEFT) ? OLED_CMD_SCROLL_VERTICAL_LEFT : OLED_CMD_SCROLL_VERTICAL_RIGHT,
+        0x00, page0, speed, page1, vertical_offset,
+        OLED_ACTIVATE_SCROLL,
+    };
+    // Rows move across page borders, so every page is rewritten when it stops
+    return oled_scroll_start(dev, cmd, sizeof(cmd), 0, (OLED_PAGES - 1));
+}
+
+uint32_t oled_stop_scroll(oled_handle_t handle)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    uint32_t ret_val = 0;
+
+    oled_bus_take(dev);
+    if (dev->scrolling)
+    {
+        ret_val = oled_scroll_stop(dev);
+    }
+    oled_bus_give();
+
+    // Frames submitted during the scroll can go out now
+    xTaskNotifyGive(g_flush_task_handle);
+    return ret_val;
+}
+
+void oled_ring_scroll(oled_handle_t handle, int8_t pages)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = dev->back;
+    uint8_t count = (pages < 0) ? -pages : pages;
+
+    if (count == 0 || oled_canvas(dev) != frame)
+    {
+        // Pages of the portrait canvas are columns of the panel, there is no ring to move
+        return;
+    }
+    if (count > OLED_PAGES)
+    {
+        count = OLED_PAGES;
+    }
+    uint16_t kept = OLED_WIDTH * (OLED_PAGES - count);
+    uint16_t exposed = OLED_WIDTH * count;
+
+    // Content and dirty windows move with the ring, so pages that kept their 
+    // content stay where they are in GDDRAM and only the exposed pages are sent
+    if (pages > 0)
+    {
+        memmove(frame->buffer, &frame->buffer[exposed], kept);
+        memmove(frame->dirty_x0, &frame->dirty_x0[count], (OLED_PAGES - count));
+        memmove(frame->dirty_x1, &frame->dirty_x1[count], (OLED_PAGES - count));
+        memset(&frame->buffer[kept], 0, exposed);
+        memset(&frame->dirty_x0[OLED_PAGES - count], 0xFF, count);
+        memset(&frame->dirty_x1[OLED_PAGES - count], 0x00, count);
+        oled_mark_dirty(frame, 0, (OLED_WIDTH - 1), (OLED_PAGES - count), (OLED_PAGES - 1));
+        frame->ring = (frame->ring + count) % OLED_PAGES;
+    }
+    else
+    {
+        memmove(&frame->buffer[exposed], frame->buffer, kept);
+        memmove(&frame->dirty_x0[count], frame->dirty_x0, (OLED_PAGES - count));
+        memmove(&frame->dirty_x1[count], frame->dirty_x1, (OLED_PAGES - count));
+        memset(frame->buffer, 0, exposed);
+        memset(frame->dirty_x0, 0xFF, count);
+        memset(frame->dirty_x1, 0x00, count);
+        oled_mark_dirty(frame, 0, (OLED_WIDTH - 1), 0, (count - 1));
+        frame->ring = (frame->ring + OLED_PAGES - count) % OLED_PAGES;
+    }
+}
+
+void oled_clear_display_h(oled_handle_t handle)
+{   
+    oled_dev_t *dev = oled_resolve(handle);
+    memset(dev->back->buffer, 0, sizeof(dev->back->buffer));   
+    oled_mark_all_dirty(dev->back);
+#if OLED_PORTRAIT_CANVAS
+    // The blank canvas matches the blank back frame, nothing left to rotate
+    memset(dev->canvas.buffer, 0, sizeof(dev->canvas.buffer));
+    oled_mark_all_clean(&dev->canvas);
+#endif
+    oled_display_prepared_frame_h(dev); 
+}
+
+void oled_clear_display()
+{
+    oled_clear_display_h(NULL);
+}
+
+void oled_load_xbm_at(oled_handle_t handle, const uint8_t *xbm, int16_t x, int16_t y, int16_t width, int16_t height)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_bitmap_t bitmap = { xbm, NULL, width, height, OLED_BITMAP_XBM };
+
+    // Set pixels are added to the frame, as the full screen loader always did
+    oled_blit(dev, &bitmap, x, y, OLED_ROP_OR);
+    oled_display_prepared_frame_h(dev);
+}
+
+void oled_load_xbm_h(oled_handle_t handle, uint8_t *xbm)
+{
+    oled_frame_t *frame = oled_canvas(oled_resolve(handle));
+    oled_load_xbm_at(handle, xbm, 0, 0, frame->width, frame->height);
+}
+
+void oled_load_xbm(uint8_t *xbm)
+{
+    oled_load_xbm_h(NULL, xbm);
+}
+
+// Optimization: Marked static inline as it is a helper
+static inline int32_t oled_draw_pixel(oled_frame_t *frame, int16_t x, int16_t y, oled_color_t color)
+{
+    if ((x >= frame->width) || (x < 0) || (y >= frame->height) || (y < 0))
+    {
+        return -1;
+    }
+
+    uint16_t index = x + (y / 8) * frame->width;
+    oled_mark_dirty(frame, x, x, (y / 8), (y / 8));
+    
+    if (color == OLED_COLOR_WHITE) {
+        frame->buffer[index] |= (1 << (y & 7));
+    } else {
+        frame->buffer[index] &= ~(1 << (y & 7));
+    }
+    return 0;
+}
+
+// Clip a rectangle to the screen, returns 0 when nothing of it is left
+static inline uint8_t oled_clip_rect(const oled_frame_t *frame, int16_t *x, int16_t *y, int16_t *w, int16_t *h)
+{
+    if (*x < 0)
+    {
+        *w += *x;
+        *x = 0;
+    }
+    if (*y < 0)
+    {
+        *h += *y;
+        *y = 0;
+    }
+    if (*x + *w > frame->width)
+    {
+        *w = frame->width - *x;
+    }
+    if (*y + *h > frame->height)
+    {
+        *h = frame->height - *y;
+    }
+    return (*w > 0 && *h > 0);
+}
+
+// Rows y0..y1 that fall into page, as a bit mask of the page byte
+static inline uint8_t oled_page_mask(uint8_t page, int16_t y0, int16_t y1)
+{
+    uint8_t mask = 0xFF;
+
+    if (page == (y0 >> 3))
+    {
+        mask &= (uint8_t)(0xFF << (y0 & 7));
+    }
+    if (page == (y1 >> 3))
+    {
+        mask &= (uint8_t)(0xFF >> (7 - (y1 & 7)));
+    }
+    return mask;
+}
+
+// byte = ((byte & keep) | set) ^ flip over columns x0..x1 of one page.
+// Whole aligned words are done four columns at a time.
+static void oled_span_op(oled_frame_t *frame, uint8_t page, uint8_t x0, uint8_t x1, uint8_t keep, uint8_t set, uint8_t flip)
+{
+    uint8_t *row = &frame->buffer[frame->width * page];
+    uint16_t x = x0;
+    uint16_t end = x1 + 1;
+
+    for (; x < end && (x & 3); x++)
+    {
+        row[x] = ((row[x] & keep) | set) ^ flip;
+    }
+    if (x + 4 <= end)
+    {
+        uint32_t keep_w = keep * 0x01010101u;
+        uint32_t set_w = set * 0x01010101u;
+        uint32_t flip_w = flip * 0x01010101u;
+        uint32_t *words = &frame->words[(frame->width * page + x) / 4];
+
+        for (; x + 4 <= end; x += 4, words++)
+        {
+            *words = ((*words & keep_w) | set_w) ^ flip_w;
+        }
+    }
+    for (; x < end; x++)
+    {
+        row[x] = ((row[x] & keep) | set) ^ flip;
+    }
+}
+
+// Replace the mask bits of columns x0..x1 of one page with the same columns of src, a page sized row
+static void oled_span_copy(oled_frame_t *frame, uint8_t page, uint8_t x0, uint8_t x1, uint8_t mask, const uint32_t *src)
+{
+    uint8_t *row = &frame->buffer[frame->width * page];
+    const uint8_t *src_row = (const uint8_t *)src;
+    uint16_t x = x0;
+    uint16_t end = x1 + 1;
+
+    for (; x < end && (x & 3); x++)
+    {
+        row[x] = (row[x] & ~mask) | (src_row[x] & mask);
+    }
+    if (x + 4 <= end)
+    {
+        uint32_t mask_w = mask * 0x01010101u;
+        uint32_t *words = &frame->words[(frame->width * page + x) / 4];
+
+        for (; x + 4 <= end; x += 4, words++)
+        {
+            *words = (*words & ~mask_w) | (src[x / 4] & mask_w);
+        }
+    }
+    for (; x < end; x++)
+    {
+        row[x] = (row[x] & ~mask) | (src_row[x] & mask);
+    }
+}
+
+// Run one span op over every page of a rectangle, masks for the partial top and bottom pages are built once per page
+static void oled_rect_op(oled_frame_t *frame, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t value, uint8_t invert)
+{
+    if (!oled_clip_rect(frame, &x, &y, &w, &h))
+    {
+        return;
+    }
+
+    int16_t y1 = y + h - 1;
+    for (uint8_t page = (y >> 3); page <= (y1 >> 3); page++)
+    {
+        uint8_t mask = oled_page_mask(page, y, y1);
+        if (invert)
+        {
+            oled_span_op(frame, page, x, x + w - 1, 0xFF, 0x00, mask);
+        }
+        else
+        {
+            oled_span_op(frame, page, x, x + w - 1, ~mask, value & mask, 0x00);
+        }
+    }
+    oled_mark_dirty(frame, x, x + w - 1, (y >> 3), (y1 >> 3));
+}
+
+void oled_fill_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    oled_rect_op(frame, x, y, w, h, (color == OLED_COLOR_WHITE) ? 0xFF : 0x00, 0);
+}
+
+void oled_clear_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    oled_rect_op(frame, x, y, w, h, 0x00, 0);
+}
+
+void oled_invert_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    oled_rect_op(frame, x, y, w, h, 0x00, 1);
+}
+
+void oled_copy_rect(oled_handle_t handle, int16_t src_x, int16_t src_y, int16_t w, int16_t h, int16_t dst_x, int16_t dst_y)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    // One destination page worth of shifted source columns, indexed by destination column
+    uint32_t shifted[OLED_WIDTH / 4];
+    uint8_t *shifted_row = (uint8_t *)shifted;
+
+    // Clip both rectangles to the screen, moving the other one along
+    if (src_x < 0) { dst_x -= src_x; w += src_x; src_x = 0; }
+    if (src_y < 0) { dst_y -= src_y; h += src_y; src_y = 0; }
+    if (dst_x < 0) { src_x -= dst_x; w += dst_x; dst_x = 0; }
+    if (dst_y < 0) { src_y -= dst_y; h += dst_y; dst_y = 0; }
+    if (src_x + w > frame->width) { w = frame->width - src_x; }
+    if (src_y + h > frame->height) { h = frame->height - src_y; }
+    if (!oled_clip_rect(frame, &dst_x, &dst_y, &w, &h))
+    {
+        return;
+    }
+
+    // Rows the pixels move down. Pages are walked away from the direction of the move,
+    // so a page is never read after it has been written.
+    int16_t shift = dst_y - src_y;
+    int16_t y1 = dst_y + h - 1;
+    int8_t step = (shift > 0) ? -1 : 1;
+    int16_t page = (shift > 0) ? (y1 >> 3) : (dst_y >> 3);
+    int16_t last = (shift > 0) ? (dst_y >> 3) : (y1 >> 3);
+
+    for (;; page += step)
+    {
+        // Source row landing on bit 0 of this page, split into a page and a bit offset
+        int16_t top = page * 8 - shift;
+        int16_t src_page = (top >= 0) ? (top >> 3) : -((7 - top) >> 3);
+        uint8_t bit = top - src_page * 8;
+        const uint8_t *lo = (src_page >= 0 && src_page < (frame->height >> 3)) ? &frame->buffer[frame->width * src_page + src_x] : NULL;
+        const uint8_t *hi = (bit && src_page + 1 >= 0 && src_page + 1 < (frame->height >> 3)) ? &frame->buffer[frame->width * (src_page + 1) + src_x] : NULL;
+
+        for (int16_t c = 0; c < w; c++)
+        {
+            uint16_t column = (lo ? lo[c] : 0) | (hi ? (uint16_t)hi[c] << 8 : 0);
+            shifted_row[dst_x + c] = (uint8_t)(column >> bit);
+        }
+        oled_span_copy(frame, page, dst_x, dst_x + w - 1, oled_page_mask(page, dst_y, y1), shifted);
+
+        if (page == last)
+        {
+            break;
+        }
+    }
+    oled_mark_dirty(frame, dst_x, dst_x + w - 1, (dst_y >> 3), (y1 >> 3));
+}
+
+// Mark the part of x0..x1, y0..y1 that is on screen as dirty
+static void oled_mark_rect(oled_frame_t *frame, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    int16_t w = x1 - x0 + 1;
+    int16_t h = y1 - y0 + 1;
+
+    if (oled_clip_rect(frame, &x0, &y0, &w, &h))
+    {
+        oled_mark_dirty(frame, x0, x0 + w - 1, (y0 >> 3), ((y0 + h - 1) >> 3));
+    }
+}
+
+// Row y from x0 to x1: the same bit of a run of bytes in one page
+static void oled_hspan(oled_frame_t *frame, int16_t x0, int16_t x1, int16_t y, uint8_t value)
+{
+    if (y < 0 || y >= frame->height)
+    {
+        return;
+    }
+    x0 = (x0 < 0) ? 0 : x0;
+    x1 = (x1 >= frame->width) ? (frame->width - 1) : x1;
+    if (x0 > x1)
+    {
+        return;
+    }
+
+    uint8_t bit = 1 << (y & 7);
+    oled_span_op(frame, (y >> 3), x0, x1, ~bit, value & bit, 0x00);
+}
+
+// Column x from y0 to y1: one masked byte write per page
+static void oled_vspan(oled_frame_t *frame, int16_t x, int16_t y0, int16_t y1, uint8_t value)
+{
+    if (x < 0 || x >= frame->width)
+    {
+        return;
+    }
+    y0 = (y0 < 0) ? 0 : y0;
+    y1 = (y1 >= frame->height) ? (frame->height - 1) : y1;
+
+    for (int16_t page = (y0 >> 3); y0 <= y1 && page <= (y1 >> 3); page++)
+    {
+        uint8_t mask = oled_page_mask(page, y0, y1);
+        uint8_t *dst = &frame->buffer[frame->width * page + x];
+        *dst = (*dst & ~mask) | (value & mask);
+    }
+}
+
+/**
+ * Pixels of a line or arc, gathered while they stay in one column and page
+ * so each byte is written once.
+ */
+typedef struct {
+    oled_frame_t *frame;
+    int16_t x;
+    int16_t page;
+    uint8_t mask;
+    uint8_t value;
+} oled_plot_t;
+
+static inline void oled_plot_flush(oled_plot_t *plot)
+{
+    if (plot->mask)
+    {
+        uint8_t *dst = &plot->frame->buffer[plot->frame->width * plot->page + plot->x];
+        *dst = (*dst & ~plot->mask) | (plot->value & plot->mask);
+        plot->mask = 0;
+    }
+}
+
+// The caller has already clipped lines, arcs check here
+static inline void oled_plot(oled_plot_t *plot, int16_t x, int16_t y)
+{
+    if (x < 0 || x >= plot->frame->width || y < 0 || y >= plot->frame->height)
+    {
+        return;
+    }
+    if (x != plot->x || (y >> 3) != plot->page)
+    {
+        oled_plot_flush(plot);
+        plot->x = x;
+        plot->page = (y >> 3);
+    }
+    plot->mask |= 1 << (y & 7);
+}
+
+// Steps i of start + dir * i that stay within 0..limit - 1, narrowing lo..hi
+static inline void oled_clip_steps(int32_t start, int8_t dir, int32_t limit, int32_t *lo, int32_t *hi)
+{
+    int32_t first = (dir > 0) ? -start : (start - (limit - 1));
+    int32_t last = (dir > 0) ? (limit - 1 - start) : start;
+
+    *lo = (first > *lo) ? first : *lo;
+    *hi = (last < *hi) ? last : *hi;
+}
+
+void oled_draw_line(oled_handle_t handle, int16_t x0, int16_t y0, int16_t x1, int16_t y1, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    uint8_t value = (color == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+
+    if (y0 == y1)
+    {
+        oled_draw_hline(dev, (x0 < x1) ? x0 : x1, y0, ((x0 < x1) ? (x1 - x0) : (x0 - x1)) + 1, color);
+        return;
+    }
+    if (x0 == x1)
+    {
+        oled_draw_vline(dev, x0, (y0 < y1) ? y0 : y1, ((y0 < y1) ? (y1 - y0) : (y0 - y1)) + 1, color);
+        return;
+    }
+
+    // Bresenham along the major axis. Pixel i is at major0 + i and minor0 + k(i) with
+    // k(i) = (2 * i * minor_len + major_len) / (2 * major_len), so the visible steps are found
+    // directly and the walk starts at the first of them.
+    uint8_t steep = ((y1 > y0) ? (y1 - y0) : (y0 - y1)) > ((x1 > x0) ? (x1 - x0) : (x0 - x1));
+    int32_t major0 = steep ? y0 : x0;
+    int32_t minor0 = steep ? x0 : y0;
+    int32_t major_d = steep ? (y1 - y0) : (x1 - x0);
+    int32_t minor_d = steep ? (x1 - x0) : (y1 - y0);
+    int8_t major_dir = (major_d < 0) ? -1 : 1;
+    int8_t minor_dir = (minor_d < 0) ? -1 : 1;
+    int32_t major_len = major_d * major_dir;
+    int32_t minor_len = minor_d * minor_dir;
+    int32_t lo = 0;
+    int32_t hi = major_len;
+    int32_t k_lo = 0;
+    int32_t k_hi = minor_len;
+
+    oled_clip_steps(major0, major_dir, steep ? frame->height : frame->width, &lo, &hi);
+    oled_clip_steps(minor0, minor_dir, steep ? frame->width : frame->height, &k_lo, &k_hi);
+    if (k_lo > k_hi)
+    {
+        return;
+    }
+    if (k_lo > 0)
+    {
+        // First step with k(i) >= k_lo
+        int64_t first = ((int64_t)(2 * k_lo - 1) * major_len + 2 * minor_len - 1) / (2 * minor_len);
+        lo = (first > lo) ? first : lo;
+    }
+    {
+        // Last step with k(i) <= k_hi
+        int64_t last = ((int64_t)(2 * k_hi + 1) * major_len - 1) / (2 * minor_len);
+        hi = (last < hi) ? last : hi;
+    }
+    if (lo > hi)
+    {
+        return;
+    }
+
+    oled_plot_t plot = { frame, -1, -1, 0, value };
+    int64_t num = (int64_t)2 * lo * minor_len + major_len;
+    int32_t k = num / (2 * major_len);
+    int32_t err = num - (int64_t)k * 2 * major_len;
+    int32_t k_first = k;
+
+    for (int32_t i = lo; i <= hi; i++)
+    {
+        int16_t major = major0 + major_dir * i;
+        int16_t minor = minor0 + minor_dir * k;
+        oled_plot(&plot, steep ? minor : major, steep ? major : minor);
+
+        err += 2 * minor_len;
+        if (err >= 2 * major_len)
+        {
+            err -= 2 * major_len;
+            k++;
+        }
+    }
+    oled_plot_flush(&plot);
+
+    // k is one past the last pixel at most, the box is only used for dirty marking
+    int16_t major_a = major0 + major_dir * lo;
+    int16_t major_b = major0 + major_dir * hi;
+    int16_t minor_a = minor0 + minor_dir * k_first;
+    int16_t minor_b = minor0 + minor_dir * k;
+    int16_t ax = steep ? minor_a : major_a;
+    int16_t bx = steep ? minor_b : major_b;
+    int16_t ay = steep ? major_a : minor_a;
+    int16_t by = steep ? major_b : minor_b;
+    oled_mark_rect(frame, (ax < bx) ? ax : bx, (ay < by) ? ay : by, (ax < bx) ? bx : ax, (ay < by) ? by : ay);
+}
+
+void oled_draw_hline(oled_handle_t handle, int16_t x, int16_t y, int16_t w, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+
+    oled_hspan(frame, x, x + w - 1, y, (color == OLED_COLOR_WHITE) ? 0xFF : 0x00);
+    oled_mark_rect(frame, x, y, x + w - 1, y);
+}
+
+void oled_draw_vline(oled_handle_t handle, int16_t x, int16_t y, int16_t h, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+
+    oled_vspan(frame, x, y, y + h - 1, (color == OLED_COLOR_WHITE) ? 0xFF : 0x00);
+    oled_mark_rect(frame, x, y, x, y + h - 1);
+}
+
+void oled_draw_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    uint8_t value = (color == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+    oled_hspan(frame, x, x + w - 1, y, value);
+    oled_hspan(frame, x, x + w - 1, y + h - 1, value);
+    oled_vspan(frame, x, y, y + h - 1, value);
+    oled_vspan(frame, x + w - 1, y, y + h - 1, value);
+    oled_mark_rect(frame, x, y, x + w - 1, y + h - 1);
+}
+
+// Quarter arcs of a circle outline, corners: 1 top left, 2 top right, 4 bottom right, 8 bottom left.
+// The points on the axes are left to the caller.
+static void oled_arc(oled_plot_t *plot, int16_t cx, int16_t cy, int16_t r, uint8_t corners)
+{
+    int16_t f = 1 - r;
+    int16_t ddf_x = 1;
+    int16_t ddf_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+        x++;
+        ddf_x += 2;
+        f += ddf_x;
+
+        if (corners & 1)
+        {
+            oled_plot(plot, cx - y, cy - x);
+            oled_plot(plot, cx - x, cy - y);
+        }
+        if (corners & 2)
+        {
+            oled_plot(plot, cx + x, cy - y);
+            oled_plot(plot, cx + y, cy - x);
+        }
+        if (corners & 4)
+        {
+            oled_plot(plot, cx + x, cy + y);
+            oled_plot(plot, cx + y, cy + x);
+        }
+        if (corners & 8)
+        {
+            oled_plot(plot, cx - y, cy + x);
+            oled_plot(plot, cx - x, cy + y);
+        }
+    }
+    oled_plot_flush(plot);
+}
+
+// Columns of the right (sides 1) or left (sides 2) half of a filled circle, each stretched down by delta rows
+static void oled_arc_fill(oled_frame_t *frame, int16_t cx, int16_t cy, int16_t r, uint8_t sides, int16_t delta, uint8_t value)
+{
+    int16_t f = 1 - r;
+    int16_t ddf_x = 1;
+    int16_t ddf_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+    int16_t px = x;
+    int16_t py = y;
+
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddf_y += 2;
+            f += ddf_y;
+        }
+        x++;
+        ddf_x += 2;
+        f += ddf_x;
+
+        // Columns at distance x cover 2y rows, skip the one the diagonal would repeat
+        if (x < (y + 1))
+        {
+            if (sides & 1)
+            {
+                oled_vspan(frame, cx + x, cy - y, cy + y + delta, value);
+            }
+            if (sides & 2)
+            {
+                oled_vspan(frame, cx - x, cy - y, cy + y + delta, value);
+            }
+        }
+        // Columns at distance y, once per change of y
+        if (y != py)
+        {
+            if (sides & 1)
+            {
+                oled_vspan(frame, cx + py, cy - px, cy + px + delta, value);
+            }
+            if (sides & 2)
+            {
+                oled_vspan(frame, cx - py, cy - px, cy + px + delta, value);
+            }
+            py = y;
+        }
+        px = x;
+    }
+}
+
+void oled_draw_circle(oled_handle_t handle, int16_t cx, int16_t cy, int16_t r, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    oled_plot_t plot = { frame, -1, -1, 0, (color == OLED_COLOR_WHITE) ? 0xFF : 0x00 };
+
+    if (r < 0)
+    {
+        return;
+    }
+    oled_plot(&plot, cx, cy - r);
+    oled_plot(&plot, cx + r, cy);
+    oled_plot(&plot, cx, cy + r);
+    oled_plot(&plot, cx - r, cy);
+    oled_arc(&plot, cx, cy, r, 0x0F);
+    oled_mark_rect(frame, cx - r, cy - r, cx + r, cy + r);
+}
+
+void oled_fill_circle(oled_handle_t handle, int16_t cx, int16_t cy, int16_t r, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    uint8_t value = (color == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+
+    if (r < 0)
+    {
+        return;
+    }
+    oled_vspan(frame, cx, cy - r, cy + r, value);
+    oled_arc_fill(frame, cx, cy, r, 0x03, 0, value);
+    oled_mark_rect(frame, cx - r, cy - r, cx + r, cy + r);
+}
+
+// Corner radius that fits the rectangle
+static inline int16_t oled_round_radius(int16_t w, int16_t h, int16_t r)
+{
+    int16_t max = ((w < h) ? w : h) / 2;
+    return (r < 0) ? 0 : ((r > max) ? max : r);
+}
+
+void oled_draw_round_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    uint8_t value = (color == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+    oled_plot_t plot = { frame, -1, -1, 0, value };
+
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+    r = oled_round_radius(w, h, r);
+    oled_hspan(frame, x + r, x + w - r - 1, y, value);
+    oled_hspan(frame, x + r, x + w - r - 1, y + h - 1, value);
+    oled_vspan(frame, x, y + r, y + h - r - 1, value);
+    oled_vspan(frame, x + w - 1, y + r, y + h - r - 1, value);
+    oled_arc(&plot, x + r, y + r, r, 0x01);
+    oled_arc(&plot, x + w - r - 1, y + r, r, 0x02);
+    oled_arc(&plot, x + w - r - 1, y + h - r - 1, r, 0x04);
+    oled_arc(&plot, x + r, y + h - r - 1, r, 0x08);
+    oled_mark_rect(frame, x, y, x + w - 1, y + h - 1);
+}
+
+void oled_fill_round_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    uint8_t value = (color == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+    r = oled_round_radius(w, h, r);
+    oled_rect_op(frame, x + r, y, w - 2 * r, h, value, 0);
+    oled_arc_fill(frame, x + w - r - 1, y + r, r, 0x01, h - 2 * r - 1, value);
+    oled_arc_fill(frame, x + r, y + r, r, 0x02, h - 2 * r - 1, value);
+    oled_mark_rect(frame, x, y, x + w - 1, y + h - 1);
+}
+
+void oled_draw_triangle(oled_handle_t handle, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, oled_color_t color)
+{
+    oled_draw_line(handle, x0, y0, x1, y1, color);
+    oled_draw_line(handle, x1, y1, x2, y2, color);
+    oled_draw_line(handle, x2, y2, x0, y0, color);
+}
+
+void oled_fill_triangle(oled_handle_t handle, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, oled_color_t color)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    uint8_t value = (color == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+    int16_t t;
+
+    // Sort by x, the triangle is filled one column span at a time
+    if (x0 > x1) { t = x0; x0 = x1; x1 = t; t = y0; y0 = y1; y1 = t; }
+    if (x1 > x2) { t = x1; x1 = x2; x2 = t; t = y1; y1 = y2; y2 = t; }
+    if (x0 > x1) { t = x0; x0 = x1; x1 = t; t = y0; y0 = y1; y1 = t; }
+
+    int16_t top = (y0 < y1) ? ((y0 < y2) ? y0 : y2) : ((y1 < y2) ? y1 : y2);
+    int16_t bottom = (y0 > y1) ? ((y0 > y2) ? y0 : y2) : ((y1 > y2) ? y1 : y2);
+
+    if (x0 == x2)
+    {
+        oled_vspan(frame, x0, top, bottom, value);
+        oled_mark_rect(frame, x0, top, x0, bottom);
+        return;
+    }
+
+    // Only the visible columns are walked
+    int16_t first = (x0 < 0) ? 0 : x0;
+    int16_t last = (x2 >= frame->width) ? (frame->width - 1) : x2;
+    for (int16_t x = first; x <= last; x++)
+    {
+        // y on the long edge x0..x2 and on the short edge the column falls into
+        int16_t a = y0 + (int32_t)(y2 - y0) * (x - x0) / (x2 - x0);
+        int16_t b = (x < x1) ? (y0 + (int32_t)(y1 - y0) * (x - x0) / (x1 - x0)) :
+                    (x1 == x2) ? y1 : (y1 + (int32_t)(y2 - y1) * (x - x1) / (x2 - x1));
+        oled_vspan(frame, x, (a < b) ? a : b, (a < b) ? b : a, value);
+    }
+    oled_mark_rect(frame, x0, top, x2, bottom);
+}
+
+// Transpose an 8x8 bit block. rows[0] is the top row with its leftmost pixel in bit 7,
+// columns[0] is the leftmost column with its top pixel in bit 0, as GDDRAM stores it.
+static inline void oled_transpose8(const uint8_t *rows, uint32_t stride, uint8_t *columns)
+{
+    uint32_t x = ((uint32_t)rows[7 * stride] << 24) | ((uint32_t)rows[6 * stride] << 16) | 
+                 ((uint32_t)rows[5 * stride] << 8) | rows[4 * stride];
+    uint32_t y = ((uint32_t)rows[3 * stride] << 24) | ((uint32_t)rows[2 * stride] << 16) | 
+                 ((uint32_t)rows[stride] << 8) | rows[0];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    columns[0] = x >> 24;
+    columns[1] = x >> 16;
+    columns[2] = x >> 8;
+    columns[3] = x;
+    columns[4] = y >> 24;
+    columns[5] = y >> 16;
+    columns[6] = y >> 8;
+    columns[7] = y;
+}
+
+// Write up to 8 pixels of one column starting at row y, bit 0 of bits is row y.
+// Only the rows set in mask are changed, spread over at most two pages.
+static inline void oled_write_column(oled_frame_t *frame, uint8_t x, uint16_t y, uint8_t bits, uint8_t mask, uint8_t fg, uint8_t bg)
+{
+    uint8_t shift = (y & 7);
+    uint16_t page = (y >> 3);
+    uint16_t value = (uint16_t)(((fg & bits) | (bg & ~bits)) & mask) << shift;
+    uint16_t keep = ~((uint16_t)mask << shift);
+
+    if (page < (frame->height >> 3))
+    {
+        uint8_t *dst = &frame->buffer[frame->width * page + x];
+        *dst = (*dst & keep) | value;
+    }
+    if (shift && (page + 1) < (frame->height >> 3))
+    {
+        uint8_t *dst = &frame->buffer[frame->width * (page + 1) + x];
+        *dst = (*dst & (keep >> 8)) | (value >> 8);
+    }
+}
+
+/**
+ * Visible part of a glyph draw in frame coordinates, inclusive and inside the frame.
+ * The whole frame for plain strings, the text box for laid out text.
+ */
+typedef struct {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+} oled_clip_t;
+
+// Glyph columns c0..c1 and rows r0..r1 inside the clip, returns 0 when nothing is visible
+static inline uint8_t oled_glyph_clip(const oled_clip_t *clip, uint8_t width, uint8_t height, int16_t x, int16_t y,
+                                      int16_t *c0, int16_t *c1, int16_t *r0, int16_t *r1)
+{
+    *c0 = (clip->x0 > x) ? (clip->x0 - x) : 0;
+    *c1 = (clip->x1 < x + width - 1) ? (clip->x1 - x) : (width - 1);
+    *r0 = (clip->y0 > y) ? (clip->y0 - y) : 0;
+    *r1 = (clip->y1 < y + height - 1) ? (clip->y1 - y) : (height - 1);
+    return (*c0 <= *c1) && (*r0 <= *r1);
+}
+
+// Rows of the 8 row band starting at glyph row row that lie within r0..r1
+static inline uint8_t oled_band_mask(int16_t row, int16_t r0, int16_t r1)
+{
+    uint8_t mask = 0xFF;
+    if (row < r0)
+    {
+        mask &= (uint8_t)(0xFF << (r0 - row));
+    }
+    if (row + 7 > r1)
+    {
+        mask &= (uint8_t)(0xFF >> (row + 7 - r1));
+    }
+    return mask;
+}
+
+// oled_write_column() for a band that may start above the frame, its rows above row 0 are masked out
+static inline void oled_write_band(oled_frame_t *frame, uint8_t x, int16_t y, uint8_t bits, uint8_t mask, uint8_t fg, uint8_t bg)
+{
+    if (y < 0)
+    {
+        bits >>= -y;
+        mask >>= -y;
+        y = 0;
+    }
+    oled_write_column(frame, x, y, bits, mask, fg, bg);
+}
+
+// Draw one glyph of a row-major font, each row padded to whole bytes with the leftmost pixel in bit 7.
+// Blocks of 8x8 pixels are transposed into GDDRAM column bytes and written with shift and mask,
+// clipping is worked out once for the whole glyph.
+static void oled_blit_glyph(oled_frame_t *frame, const oled_clip_t *clip, const uint8_t *bitmap, uint8_t width, uint8_t height, 
+                            int16_t x, int16_t y, oled_color_t foreground, oled_color_t background)
+{
+    uint8_t fg = (foreground == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+    uint8_t bg = (background == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+    uint8_t row_bytes = (width + 7) / 8;
+    int16_t c0, c1, r0, r1;
+
+    if (width == 0 || height == 0 || !oled_glyph_clip(clip, width, height, x, y, &c0, &c1, &r0, &r1))
+    {
+        return;
+    }
+
+    for (int16_t row = (r0 & ~7); row <= r1; row += 8)
+    {
+        uint8_t rows = (height - row) < 8 ? (height - row) : 8;
+        uint8_t mask = oled_band_mask(row, r0, r1);
+        uint8_t block[8] = { 0 };
+        uint8_t columns[8];
+
+        for (int16_t byte = c0 / 8; byte <= c1 / 8; byte++)
+        {
+            for (uint8_t r = 0; r < rows; r++)
+            {
+                block[r] = bitmap[row_bytes * (row + r) + byte];
+            }
+            oled_transpose8(block, 1, columns);
+
+            int16_t first = (byte * 8 > c0) ? (byte * 8) : c0;
+            int16_t last = (byte * 8 + 7 < c1) ? (byte * 8 + 7) : c1;
+            for (int16_t c = first; c <= last; c++)
+            {
+                oled_write_band(frame, x + c, y + row, columns[c - byte * 8], mask, fg, bg);
+            }
+        }
+    }
+
+    oled_mark_dirty(frame, x + c0, x + c1, (y + r0) / 8, (y + r1) / 8);
+}
+
+// Draw one glyph of a page-major font, stored as the panel stores it: width column bytes for
+// each 8 row page, top row in bit 0. On a page boundary in plain colors a full page is one memcpy,
+// anything else goes through the same shift and mask as the row-major path.
+static void oled_blit_glyph_pages(oled_frame_t *frame, const oled_clip_t *clip, const uint8_t *bitmap, uint8_t width, uint8_t height, 
+                                  int16_t x, int16_t y, oled_color_t foreground, oled_color_t background)
+{
+    uint8_t fg = (foreground == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+    uint8_t bg = (background == OLED_COLOR_WHITE) ? 0xFF : 0x00;
+    uint8_t copy = ((y & 7) == 0) && (fg == 0xFF) && (bg == 0x00);
+    int16_t c0, c1, r0, r1;
+
+    if (width == 0 || height == 0 || !oled_glyph_clip(clip, width, height, x, y, &c0, &c1, &r0, &r1))
+    {
+        return;
+    }
+
+    for (int16_t row = (r0 & ~7); row <= r1; row += 8)
+    {
+        uint8_t mask = oled_band_mask(row, r0, r1);
+        const uint8_t *columns = bitmap + (uint16_t)width * (row / 8);
+
+        if (copy && mask == 0xFF)
+        {
+            memcpy(&frame->buffer[frame->width * ((y + row) / 8) + x + c0], &columns[c0], c1 - c0 + 1);
+            continue;
+        }
+        for (int16_t c = c0; c <= c1; c++)
+        {
+            oled_write_band(frame, x + c, y + row, columns[c], mask, fg, bg);
+        }
+    }
+
+    oled_mark_dirty(frame, x + c0, x + c1, (y + r0) / 8, (y + r1) / 8);
+}
+
+// Combine src into the mask bits of dst with a raster op
+static inline uint8_t oled_rop_apply(uint8_t dst, uint8_t src, uint8_t mask, oled_rop_t rop)
+{
+    switch (rop)
+    {
+        case OLED_ROP_OR:
+            return dst | (src & mask);
+        case OLED_ROP_AND_NOT:
+            return dst & ~(src & mask);
+        case OLED_ROP_XOR:
+            return dst ^ (src & mask);
+        case OLED_ROP_COPY:
+        default:
+            return (dst & ~mask) | (src & mask);
+    }
+}
+
+// Column bytes of one 8 row page of an XBM image for columns x0..x1, transposed 8x8 at a time.
+// XBM rows are LSB first, so the transpose hands out the columns of a block in reverse order.
+static void oled_xbm_page_columns(const uint8_t *xbm, uint16_t width, uint16_t height, uint16_t page, 
+                                  uint16_t x0, uint16_t x1, uint8_t *out)
+{
+    uint16_t row_bytes = (width + 7) / 8;
+    uint16_t row = page * 8;
+    uint8_t rows = (height - row) < 8 ? (height - row) : 8;
+    uint8_t block[8] = { 0 };
+    uint8_t columns[8];
+
+    for (uint16_t byte = (x0 / 8); byte <= (x1 / 8); byte++)
+    {
+        if (rows == 8)
+        {
+            oled_transpose8(&xbm[row_bytes * row + byte], row_bytes, columns);
+        }
+        else
+        {
+            for (uint8_t r = 0; r < rows; r++)
+            {
+                block[r] = xbm[row_bytes * (row + r) + byte];
+            }
+            oled_transpose8(block, 1, columns);
+        }
+
+        uint16_t first = (byte * 8 > x0) ? (byte * 8) : x0;
+        uint16_t last = (byte * 8 + 7 < x1) ? (byte * 8 + 7) : x1;
+        for (uint16_t c = first; c <= last; c++)
+        {
+            out[c - x0] = columns[7 - (c & 7)];
+        }
+    }
+}
+
+void oled_blit(oled_handle_t handle, const oled_bitmap_t *bitmap, int16_t x, int16_t y, oled_rop_t rop)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    uint8_t columns[OLED_WIDTH];
+    uint8_t mask_columns[OLED_WIDTH];
+
+    if (bitmap == NULL || bitmap->data == NULL || bitmap->width <= 0 || bitmap->height <= 0)
+    {
+        return;
+    }
+
+    // Visible source columns and the destination page the first source page lands in
+    int16_t x0 = (x < 0) ? -x : 0;
+    int16_t x1 = (x + bitmap->width > frame->width) ? (frame->width - 1 - x) : (bitmap->width - 1);
+    int16_t page_base = (y >= 0) ? (y >> 3) : -((7 - y) >> 3);
+    uint8_t shift = y - page_base * 8;
+    uint16_t pages = (bitmap->height + 7) / 8;
+
+    if (x0 > x1 || y >= frame->height || y + bitmap->height <= 0)
+    {
+        return;
+    }
+
+    for (uint16_t page = 0; page < pages; page++)
+    {
+        int16_t dst_page = page_base + page;
+        uint8_t lo_visible = (dst_page >= 0 && dst_page < (frame->height >> 3));
+        uint8_t hi_visible = shift && (dst_page + 1 >= 0 && dst_page + 1 < (frame->height >> 3));
+        uint8_t rows = (bitmap->height - page * 8) < 8 ? (bitmap->height - page * 8) : 8;
+        uint8_t row_mask = (uint8_t)(0xFF >> (8 - rows));
+        const uint8_t *src = columns;
+        const uint8_t *src_mask = mask_columns;
+
+        if (!lo_visible && !hi_visible)
+        {
+            continue;
+        }
+
+        if (bitmap->format == OLED_BITMAP_PAGES)
+        {
+            src = bitmap->data + bitmap->width * page + x0;
+            src_mask = bitmap->mask ? (bitmap->mask + bitmap->width * page + x0) : NULL;
+        }
+        else
+        {
+            oled_xbm_page_columns(bitmap->data, bitmap->width, bitmap->height, page, x0, x1, columns);
+            src_mask = NULL;
+            if (bitmap->mask)
+            {
+                oled_xbm_page_columns(bitmap->mask, bitmap->width, bitmap->height, page, x0, x1, mask_columns);
+                src_mask = mask_columns;
+            }
+        }
+
+        uint8_t *lo = lo_visible ? &frame->buffer[frame->width * dst_page + x + x0] : NULL;
+        uint8_t *hi = hi_visible ? &frame->buffer[frame->width * (dst_page + 1) + x + x0] : NULL;
+        for (int16_t c = 0; c <= x1 - x0; c++)
+        {
+            uint16_t value = (uint16_t)src[c] << shift;
+            uint16_t mask = (uint16_t)(src_mask ? (src_mask[c] & row_mask) : row_mask) << shift;
+
+            if (lo)
+            {
+                lo[c] = oled_rop_apply(lo[c], value, mask, rop);
+            }
+            if (hi)
+            {
+                hi[c] = oled_rop_apply(hi[c], value >> 8, mask >> 8, rop);
+            }
+        }
+    }
+
+    oled_mark_rect(frame, x, y, x + bitmap->width - 1, y + bitmap->height - 1);
+}
+
+#if OLED_GLYPH_CACHE_SLOTS
+// Convert a row-major glyph to page-major column bytes, rows past the height are left blank
+static void oled_glyph_to_pages(const uint8_t *bitmap, uint8_t width, uint8_t height, uint8_t *out)
+{
+    uint8_t row_bytes = (width + 7) / 8;
+
+    for (uint8_t row = 0; row < height; row += 8)
+    {
+        uint8_t rows = (height - row) < 8 ? (height - row) : 8;
+        uint8_t block[8] = { 0 };
+        uint8_t columns[8];
+
+        for (uint8_t byte = 0; byte * 8 < width; byte++)
+        {
+            for (uint8_t r = 0; r < rows; r++)
+            {
+                block[r] = bitmap[row_bytes * (row + r) + byte];
+            }
+            oled_transpose8(block, 1, columns);
+
+            uint8_t count = (width - byte * 8) < 8 ? (width - byte * 8) : 8;
+            memcpy(&out[width * (row / 8) + byte * 8], columns, count);
+        }
+    }
+}
+
+// Page-major bitmap of a glyph from the cache, converted on a miss. NULL when the glyph does not fit a slot.
+// Called with g_glyph_lock held.
+static const uint8_t *oled_glyph_cache_get(const font_info_t *font, char c, const font_char_desc_t *d)
+{
+    uint16_t size = (uint16_t)d->width * ((font->height + 7) / 8);
+    oled_glyph_slot_t *slot = &g_glyph_cache[0];
+
+    if (size > OLED_GLYPH_CACHE_SLOT_BYTES)
+    {
+        return NULL;
+    }
+
+    g_glyph_clock++;
+    for (uint8_t i = 0; i < OLED_GLYPH_CACHE_SLOTS; i++)
+    {
+        oled_glyph_slot_t *s = &g_glyph_cache[i];
+        if (s->font == font && s->c == c)
+        {
+            s->last_used = g_glyph_clock;
+            g_glyph_stats.hits++;
+            return s->columns;
+        }
+        if (s->font == NULL)
+        {
+            // Free slots are never behind a used one, nothing further down can match
+            slot = s;
+            break;
+        }
+        if (s->last_used < slot->last_used)
+        {
+            slot = s;
+        }
+    }
+
+    g_glyph_stats.misses++;
+    if (slot->font != NULL)
+    {
+        g_glyph_stats.evictions++;
+    }
+    if (font->format == FONT_FORMAT_PAGES)
+    {
+        memcpy(slot->columns, font->bitmap + d->offset, size);
+    }
+    else
+    {
+        oled_glyph_to_pages(font->bitmap + d->offset, d->width, font->height, slot->columns);
+    }
+    slot->font = font;
+    slot->c = c;
+    slot->width = d->width;
+    slot->last_used = g_glyph_clock;
+    return slot->columns;
+}
+#endif
+
+// Draw one character from the glyph cache or straight from the font, glyphs outside the clip are skipped
+// before the cache is touched. Returns the descriptor, NULL when the font has no glyph for c.
+// Called with g_glyph_lock held.
+static const font_char_desc_t *oled_draw_char(oled_frame_t *frame, const oled_clip_t *clip, const font_info_t *font, char c,
+                                              int16_t x, int16_t y, oled_color_t foreground, oled_color_t background)
+{
+    const font_char_desc_t *d = font_get_char_desc(font, c);
+
+    if (d == NULL || x > clip->x1 || x + d->width <= clip->x0 || y > clip->y1 || y + font->height <= clip->y0)
+    {
+        return d;
+    }
+#if OLED_GLYPH_CACHE_SLOTS
+    const uint8_t *cached = oled_glyph_cache_get(font, c, d);
+    if (cached != NULL)
+    {
+        oled_blit_glyph_pages(frame, clip, cached, d->width, font->height, x, y, foreground, background);
+        return d;
+    }
+#endif
+    if (font->format == FONT_FORMAT_PAGES)
+    {
+        oled_blit_glyph_pages(frame, clip, font->bitmap + d->offset, d->width, font->height, x, y, foreground, background);
+    }
+    else
+    {
+        oled_blit_glyph(frame, clip, font->bitmap + d->offset, d->width, font->height, x, y, foreground, background);
+    }
+    return d;
+}
+
+int32_t oled_prepare_string_frame_h(oled_handle_t handle, const font_info_t *font, int16_t x, int16_t y, const char *str, oled_color_t foreground, oled_color_t background)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    oled_clip_t clip = { 0, 0, frame->width - 1, frame->height - 1 };
+    int16_t cursor = x;
+
+    if (font == NULL || str == NULL)
+    {
+        return 0;
+    }
+
+#if OLED_GLYPH_CACHE_SLOTS
+    xSemaphoreTake(g_glyph_lock, portMAX_DELAY);
+#endif
+    while (*str) 
+    {
+        const font_char_desc_t *d = oled_draw_char(frame, &clip, font, *str, cursor, y, foreground, background);
+        if (d != NULL)
+        {
+            cursor += d->width;
         }
         
         ++str;
         if (*str)
         {
-            x += font->c;
+            cursor += font->c;
         }
     }
+#if OLED_GLYPH_CACHE_SLOTS
+    xSemaphoreGive(g_glyph_lock);
+#endif
     
-    return x - t;
+    return cursor - x;
+}
+
+int32_t oled_prepare_string_frame(const font_info_t *font, int16_t x, int16_t y, const char *str, oled_color_t foreground, oled_color_t background)
+{
+    return oled_prepare_string_frame_h(NULL, font, x, y, str, foreground, background);
+}
+
+/**
+ * One line of a text box, found by the measure pass.
+ */
+typedef struct {
+    uint16_t start;                     // Offset of the first character in the string
+    uint16_t len;
+    int16_t width;                      // Pixels, the ellipsis included
+    uint8_t ellipsis;
+} oled_text_line_t;
+
+static const char g_ellipsis[] = "...";
+
+// Measure pass of oled_draw_text_box(): break str into at most max_lines lines of the box width.
+// Every character is measured once, widths are counted as in font_measure_string(), the gap
+// font->c included after each glyph while scanning. Returns the offset of the first character not laid out.
+static uint16_t oled_text_layout(const font_info_t *font, const oled_text_box_t *box, const char *str,
+                                 oled_text_line_t *lines, uint8_t max_lines, uint8_t *line_count)
+{
+    int16_t ellipsis_width = box->ellipsis ? font_measure_string(font, g_ellipsis) : 0;
+    uint16_t pos = 0;
+    uint8_t count = 0;
+
+    while (str[pos] && count < max_lines)
+    {
+        oled_text_line_t *line = &lines[count++];
+        uint8_t last_line = (count == max_lines);
+        int16_t width = 0;              // Glyphs so far, each followed by the gap
+        uint16_t len = 0;
+        int16_t break_width = 0;        // Line up to the last space
+        uint16_t break_len = 0;
+        int16_t fit_width = 0;          // Longest part that leaves room for the ellipsis, without trailing spaces
+        uint16_t fit_len = 0;
+        uint8_t overflow = 0;
+        char c;
+
+        while ((c = str[pos + len]) != '\0' && c != '\n')
+        {
+            const font_char_desc_t *d = font_get_char_desc(font, c);
+            if (c == ' ' && len > 0 && str[pos + len - 1] != ' ')
+            {
+                break_width = width;
+                break_len = len;
+            }
+            // The first glyph always goes on the line, even when it is wider than the box
+            if (d != NULL && len > 0 && width + d->width > box->width)
+            {
+                overflow = 1;
+                break;
+            }
+            width += (d != NULL) ? (d->width + font->c) : 0;
+            len++;
+            if (c != ' ' && width + ellipsis_width <= box->width)
+            {
+                fit_width = width;
+                fit_len = len;
+            }
+        }
+
+        uint16_t next = pos + len;
+        line->start = pos;
+        line->ellipsis = 0;
+        if (overflow && box->wrap && !(last_line && box->ellipsis))
+        {
+            if (break_len > 0)
+            {
+                width = break_width;
+                len = break_len;
+            }
+            // The next line starts at the next word
+            next = pos + len;
+            while (str[next] == ' ')
+            {
+                next++;
+            }
+            if (str[next] == '\n')
+            {
+                next++;
+            }
+        }
+        else if (overflow || (last_line && c == '\n' && str[next + 1] != '\0'))
+        {
+            // Text is cut here: the rest of an unwrapped line, or everything after the last line
+            if (box->ellipsis)
+            {
+                width = fit_width + ellipsis_width + font->c;
+                len = fit_len;
+                line->ellipsis = 1;
+            }
+            if (last_line)
+            {
+                next = pos + len;
+            }
+            else
+            {
+                while (str[next] != '\0' && str[next] != '\n')
+                {
+                    next++;
+                }
+                next += (str[next] == '\n');
+            }
+        }
+        else
+        {
+            next += (c == '\n');
+        }
+
+        line->len = len;
+        line->width = (width > 0) ? (width - font->c) : 0;
+        pos = next;
+    }
+
+    *line_count = count;
+    return pos;
+}
+
+int32_t oled_draw_text_box(oled_handle_t handle, const font_info_t *font, const oled_text_box_t *box, const char *str,
+                           oled_color_t foreground, oled_color_t background)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *frame = oled_canvas(dev);
+    oled_text_line_t lines[OLED_TEXT_MAX_LINES];
+    uint8_t count = 0;
+
+    if (font == NULL || box == NULL || str == NULL || box->width <= 0 || box->height <= 0)
+    {
+        return 0;
+    }
+
+    int16_t line_height = font->height + box->line_spacing;
+    int16_t max_lines = (box->height + box->line_spacing) / line_height;
+    max_lines = (max_lines < OLED_TEXT_MAX_LINES) ? max_lines : OLED_TEXT_MAX_LINES;
+    uint16_t laid_out = oled_text_layout(font, box, str, lines, max_lines, &count);
+
+    // The box is cleared to the background and drawn whole, nothing outside it is touched
+    int16_t x = box->x, y = box->y, w = box->width, h = box->height;
+    if (!oled_clip_rect(frame, &x, &y, &w, &h))
+    {
+        return laid_out;
+    }
+    oled_clip_t clip = { x, y, x + w - 1, y + h - 1 };
+    oled_rect_op(frame, x, y, w, h, (background == OLED_COLOR_WHITE) ? 0xFF : 0x00, 0);
+
+#if OLED_GLYPH_CACHE_SLOTS
+    xSemaphoreTake(g_glyph_lock, portMAX_DELAY);
+#endif
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const oled_text_line_t *line = &lines[i];
+        int16_t top = box->y + i * line_height;
+        int16_t cursor = box->x;
+
+        if (box->align == OLED_ALIGN_CENTER)
+        {
+            cursor += (box->width - line->width) / 2;
+        }
+        else if (box->align == OLED_ALIGN_RIGHT)
+        {
+            cursor += box->width - line->width;
+        }
+
+        // Blit pass, widths are known and nothing is measured again
+        for (uint16_t k = 0; k < line->len && cursor <= clip.x1; k++)
+        {
+            const font_char_desc_t *d = oled_draw_char(frame, &clip, font, str[line->start + k], cursor, top, foreground, background);
+            if (d != NULL)
+            {
+                cursor += d->width + font->c;
+            }
+        }
+        for (const char *e = g_ellipsis; line->ellipsis && *e; e++)
+        {
+            const font_char_desc_t *d = oled_draw_char(frame, &clip, font, *e, cursor, top, foreground, background);
+            if (d != NULL)
+            {
+                cursor += d->width + font->c;
+            }
+        }
+    }
+#if OLED_GLYPH_CACHE_SLOTS
+    xSemaphoreGive(g_glyph_lock);
+#endif
+
+    return laid_out;
+}
+
+#if OLED_PORTRAIT_CANVAS
+// Rotate the dirty 8x8 tiles of the portrait canvas into the back frame, each one a single transpose.
+// OLED_ROTATION_90 puts canvas row y in panel column y and canvas column x in panel row 63 - x,
+// OLED_ROTATION_270 puts it in panel column 127 - y and panel row x.
+static void oled_rotate_canvas(oled_dev_t *dev)
+{
+    oled_frame_t *canvas = &dev->canvas;
+    oled_frame_t *frame = dev->back;
+    uint8_t block[8];
+    uint8_t columns[8];
+
+    for (uint8_t page = 0; page < (canvas->height >> 3); page++)
+    {
+        if (canvas->dirty_x0[page] > canvas->dirty_x1[page])
+        {
+            continue;
+        }
+        for (uint8_t tile = (canvas->dirty_x0[page] >> 3); tile <= (canvas->dirty_x1[page] >> 3); tile++)
+        {
+            const uint8_t *src = &canvas->buffer[canvas->width * page + tile * 8];
+
+            if (dev->rotation == OLED_ROTATION_90)
+            {
+                uint8_t frame_page = OLED_PAGES - 1 - tile;
+                uint8_t *dst = &frame->buffer[OLED_WIDTH * frame_page + page * 8];
+                for (uint8_t i = 0; i < 8; i++)
+                {
+                    block[i] = src[7 - i];
+                }
+                oled_transpose8(block, 1, columns);
+                for (uint8_t i = 0; i < 8; i++)
+                {
+                    dst[i] = columns[7 - i];
+                }
+                oled_mark_dirty(frame, page * 8, page * 8 + 7, frame_page, frame_page);
+            }
+            else
+            {
+                uint8_t x = OLED_WIDTH - 8 - page * 8;
+                oled_transpose8(src, 1, &frame->buffer[OLED_WIDTH * tile + x]);
+                oled_mark_dirty(frame, x, x + 7, tile, tile);
+            }
+        }
+    }
+    oled_mark_all_clean(canvas);
+}
+
+uint32_t oled_set_rotation(oled_handle_t handle, oled_rotation_t rotation)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+
+    if (rotation != OLED_ROTATION_0 && rotation != OLED_ROTATION_90 && rotation != OLED_ROTATION_270)
+    {
+        return 1;
+    }
+    if (rotation != dev->rotation)
+    {
+        // Coordinates change meaning, start from a blank screen
+        dev->rotation = rotation;
+        memset(dev->back->buffer, 0, sizeof(dev->back->buffer));
+        memset(dev->canvas.buffer, 0, sizeof(dev->canvas.buffer));
+        oled_mark_all_dirty(dev->back);
+        oled_mark_all_clean(&dev->canvas);
+    }
+    return 0;
+}
+#else
+uint32_t oled_set_rotation(oled_handle_t handle, oled_rotation_t rotation)
+{
+    return (rotation == OLED_ROTATION_0) ? 0 : 1;
+}
+#endif
+
+void oled_display_prepared_frame_h(oled_handle_t handle)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    oled_frame_t *submitted = dev->back;
+
+#if OLED_PORTRAIT_CANVAS
+    if (dev->rotation != OLED_ROTATION_0)
+    {
+        oled_rotate_canvas(dev);
+    }
+#endif
+    submitted->seq = ++dev->submit_seq;
+
+    taskENTER_CRITICAL();
+    if (dev->mailbox_full)
+    {
+        // Latest wins: the waiting frame never reached the panel, 
+        // so its dirty windows have to be sent along with this one, moved by any ring scroll since
+        uint8_t shift = (dev->mailbox->ring + OLED_PAGES - submitted->ring) % OLED_PAGES;
+        for (uint8_t page = 0; page < OLED_PAGES; page++)
+        {
+            if (dev->mailbox->dirty_x0[page] <= dev->mailbox->dirty_x1[page])
+            {
+                uint8_t moved = (page + shift) % OLED_PAGES;
+                oled_mark_dirty(submitted, dev->mailbox->dirty_x0[page], dev->mailbox->dirty_x1[page], moved, moved);
+            }
+        }
+        dev->frame_stats.dropped++;
+    }
+    dev->back = dev->mailbox;
+    dev->mailbox = submitted;
+    dev->mailbox_full = 1;
+    taskEXIT_CRITICAL();
+
+    // The new back frame holds an older or dropped frame, drawing continues on top of the submitted one.
+    // Only the flush task reads the submitted buffer meanwhile.
+    memcpy(dev->back->buffer, submitted->buffer, sizeof(dev->back->buffer));
+    dev->back->ring = submitted->ring;
+    oled_mark_all_clean(dev->back);
+
+    if (dev->frame_rate == 0)
+    {
+        xTaskNotifyGive(g_flush_task_handle);
+    }
 }
 
 void oled_display_prepared_frame()
 {
-    oled_load_frame(g_frame_buffer);
-}
\ No newline at end of file
+    oled_display_prepared_frame_h(NULL);
+}
+
+uint32_t oled_wait_frame_done_h(oled_handle_t handle, uint32_t timeout_ms)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    // One deadline for all frames still queued, a non-zero timeout waits at least one tick
+    TickType_t remaining = (timeout_ms / portTICK_PERIOD_MS) + ((timeout_ms % portTICK_PERIOD_MS) ? 1 : 0);
+    TimeOut_t timeout;
+
+    vTaskSetTimeOutState(&timeout);
+    while (dev->done_seq != dev->submit_seq)
+    {
+        if (xTaskCheckForTimeOut(&timeout, &remaining) != pdFALSE ||
+            xSemaphoreTake(dev->frame_done, remaining) != pdTRUE)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint32_t oled_wait_frame_done(uint32_t timeout_ms)
+{
+    return oled_wait_frame_done_h(NULL, timeout_ms);
+}
+
+uint32_t oled_set_frame_rate_h(oled_handle_t handle, uint32_t fps)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    uint32_t ret_val = 0;
+
+    if (fps > OLED_FRAME_RATE_MAX)
+    {
+        oled_debug("Oled frame rate too high");
+        return 1;
+    }
+    if (dev->pace_timer == NULL)
+    {
+        esp_timer_create_args_t args = 
+        {
+            .callback = &oled_pace_timer_callback,
+            .arg = dev,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "oled_pace",
+        };
+        if (esp_timer_create(&args, &dev->pace_timer))
+        {
+            oled_debug("Oled pacing timer create error");
+            return 1;
+        }
+    }
+    else if (dev->frame_rate)
+    {
+        esp_timer_stop(dev->pace_timer);
+    }
+
+    dev->frame_rate = fps;
+    if (fps)
+    {
+        if (esp_timer_start_periodic(dev->pace_timer, (1000000 / fps)))
+        {
+            oled_debug("Oled pacing timer start error");
+            dev->frame_rate = 0;
+            ret_val = 1;
+        }
+    }
+    // Frames waiting for the timer are sent right away once pacing is off
+    xTaskNotifyGive(g_flush_task_handle);
+    return ret_val;
+}
+
+uint32_t oled_set_frame_rate(uint32_t fps)
+{
+    return oled_set_frame_rate_h(NULL, fps);
+}
+
+void oled_get_frame_stats_h(oled_handle_t handle, oled_frame_stats_t *stats)
+{
+    oled_dev_t *dev = oled_resolve(handle);
+    taskENTER_CRITICAL();
+    *stats = dev->frame_stats;
+    taskEXIT_CRITICAL();
+}
+
+void oled_get_frame_stats(oled_frame_stats_t *stats)
+{
+    oled_get_frame_stats_h(NULL, stats);
+}
+
+void oled_get_glyph_cache_stats(oled_glyph_cache_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = g_glyph_stats;
+    taskEXIT_CRITICAL();
+}
+
+void oled_reset_glyph_cache_stats(void)
+{
+    taskENTER_CRITICAL();
+    g_glyph_stats.hits = 0;
+    g_glyph_stats.misses = 0;
+    g_glyph_stats.evictions = 0;
+    taskEXIT_CRITICAL();
+}
+
+#ifdef OLED_BENCHMARK
+
+#define OLED_BENCHMARK_ROUNDS       64
+
+// Time rounds of a drawing step, in us per round
+#define OLED_BENCHMARK_TIME(result, step)                               \
+    do {                                                                \
+        int64_t start = esp_timer_get_time();                           \
+        for (uint32_t round = 0; round < OLED_BENCHMARK_ROUNDS; round++) \
+        {                                                               \
+            step;                                                       \
+        }                                                               \
+        result = (esp_timer_get_time() - start) / OLED_BENCHMARK_ROUNDS; \
+    } while (0)
+
+// Per pixel versions of the rectangle kernels, kept only for comparison
+static void oled_benchmark_fill_pixels(oled_frame_t *frame, int16_t x, int16_t y, int16_t w, int16_t h, oled_color_t color)
+{
+    for (int16_t row = y; row < y + h; row++)
+    {
+        for (int16_t column = x; column < x + w; column++)
+        {
+            oled_draw_pixel(frame, column, row, color);
+        }
+    }
+}
+
+static void oled_benchmark_invert_pixels(oled_frame_t *frame, int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    for (int16_t row = y; row < y + h; row++)
+    {
+        for (int16_t column = x; column < x + w; column++)
+        {
+            uint8_t on = (frame->buffer[OLED_WIDTH * (row / 8) + column] >> (row & 7)) & 1;
+            oled_draw_pixel(frame, column, row, on ? OLED_COLOR_BLACK : OLED_COLOR_WHITE);
+        }
+    }
+}
+
+static void oled_benchmark_copy_pixels(oled_frame_t *frame, int16_t src_x, int16_t src_y, int16_t w, int16_t h, int16_t dst_x, int16_t dst_y)
+{
+    for (int16_t row = 0; row < h; row++)
+    {
+        for (int16_t column = 0; column < w; column++)
+        {
+            uint8_t on = (frame->buffer[OLED_WIDTH * ((src_y + row) / 8) + src_x + column] >> ((src_y + row) & 7)) & 1;
+            oled_draw_pixel(frame, dst_x + column, dst_y + row, on ? OLED_COLOR_WHITE : OLED_COLOR_BLACK);
+        }
+    }
+}
+
+// Former oled_load_xbm() conversion, one bit at a time
+static void oled_benchmark_xbm_bits(oled_frame_t *frame, const uint8_t *xbm)
+{
+    for (int32_t row = 0; row < OLED_HEIGHT; row++) 
+    {
+        for (int32_t column = 0; column < OLED_WIDTH / 8; column++) 
+        {
+            uint16_t xbm_offset = row * 16 + column;
+            for (uint8_t bit = 0; bit < 8; bit++) 
+            {
+                if (*(xbm + xbm_offset) & (1 << bit)) 
+                {
+                    *(frame->buffer + OLED_WIDTH * (row / 8) + column * 8 + bit) |= (1 << (row % 8));
+                }
+            }
+        }
+    }
+    oled_mark_all_dirty(frame);
+}
+
+void oled_benchmark(void)
+{
+    oled_dev_t *dev = g_default;
+    int64_t pixels_us = 0;
+    int64_t kernel_us = 0;
+
+    if (dev == NULL)
+    {
+        return;
+    }
+
+    OLED_BENCHMARK_TIME(pixels_us, oled_benchmark_fill_pixels(dev->back, 0, 0, OLED_WIDTH, OLED_HEIGHT, OLED_COLOR_WHITE));
+    OLED_BENCHMARK_TIME(kernel_us, oled_fill_rect(dev, 0, 0, OLED_WIDTH, OLED_HEIGHT, OLED_COLOR_WHITE));
+    printf("\n[Bench] fill 128x64: per pixel %u us, kernel %u us", (unsigned int)pixels_us, (unsigned int)kernel_us);
+
+    OLED_BENCHMARK_TIME(pixels_us, oled_benchmark_fill_pixels(dev->back, 5, 3, 100, 40, OLED_COLOR_BLACK));
+    OLED_BENCHMARK_TIME(kernel_us, oled_clear_rect(dev, 5, 3, 100, 40));
+    printf("\n[Bench] clear 100x40: per pixel %u us, kernel %u us", (unsigned int)pixels_us, (unsigned int)kernel_us);
+
+    OLED_BENCHMARK_TIME(pixels_us, oled_benchmark_invert_pixels(dev->back, 0, 20, OLED_WIDTH, 12));
+    OLED_BENCHMARK_TIME(kernel_us, oled_invert_rect(dev, 0, 20, OLED_WIDTH, 12));
+    printf("\n[Bench] invert 128x12: per pixel %u us, kernel %u us", (unsigned int)pixels_us, (unsigned int)kernel_us);
+
+    OLED_BENCHMARK_TIME(pixels_us, oled_benchmark_copy_pixels(dev->back, 0, 0, 64, 30, 60, 27));
+    OLED_BENCHMARK_TIME(kernel_us, oled_copy_rect(dev, 0, 0, 64, 30, 60, 27));
+    printf("\n[Bench] copy 64x30: per pixel %u us, kernel %u us", (unsigned int)pixels_us, (unsigned int)kernel_us);
+
+    static uint8_t xbm[OLED_WIDTH * OLED_HEIGHT / 8];
+    oled_bitmap_t image = { xbm, NULL, OLED_WIDTH, OLED_HEIGHT, OLED_BITMAP_XBM };
+    for (uint16_t i = 0; i < sizeof(xbm); i++)
+    {
+        xbm[i] = i * 37;
+    }
+    OLED_BENCHMARK_TIME(pixels_us, oled_benchmark_xbm_bits(dev->back, xbm));
+    OLED_BENCHMARK_TIME(kernel_us, oled_blit(dev, &image, 0, 0, OLED_ROP_OR));
+    printf("\n[Bench] xbm 128x64: per bit %u us, transpose %u us", (unsigned int)pixels_us, (unsigned int)kernel_us);
+
+    oled_clear_display_h(dev);
+}
+#endif
@@ -9,9 +9,15 @@
  */
 typedef enum {
     OLED_SEND_DATA = 0x0,
-    OLED_FUNCTION_YEILD = 0x1 // Kept spelling as per implementation
+    OLED_FUNCTION_YEILD = 0x1, // Kept spelling as per implementation
+    OLED_SEND_SEGMENTS = 0x2   // One transaction made of all segments, only with OLED_TRANSPORT_SEGMENTS
 } oled_info_type_t;
 
+/**
+ * @brief Transport capabilities passed to oled_init_transport()
+ */
+#define OLED_TRANSPORT_SEGMENTS     0x01    //!< Callback handles OLED_SEND_SEGMENTS
+
 /**
  * @brief OLED pixel colors
  */
@@ -20,6 +26,154 @@ typedef enum {
     OLED_COLOR_WHITE = 1,        //!< White (pixel on)    
 } oled_color_t;
 
+/**
+ * @brief Hardware scroll direction
+ */
+typedef enum {
+    OLED_SCROLL_RIGHT = 0,
+    OLED_SCROLL_LEFT = 1,
+} oled_scroll_dir_t;
+
+/**
+ * @brief Hardware scroll step interval, in panel frames (SSD1306 interval codes)
+ */
+typedef enum {
+    OLED_SCROLL_FRAMES_2 = 0x07,
+    OLED_SCROLL_FRAMES_3 = 0x04,
+    OLED_SCROLL_FRAMES_4 = 0x05,
+    OLED_SCROLL_FRAMES_5 = 0x00,
+    OLED_SCROLL_FRAMES_25 = 0x06,
+    OLED_SCROLL_FRAMES_64 = 0x01,
+    OLED_SCROLL_FRAMES_128 = 0x02,
+    OLED_SCROLL_FRAMES_256 = 0x03,
+} oled_scroll_speed_t;
+
+/**
+ * @brief Drawing orientation, see oled_set_rotation()
+ */
+typedef enum {
+    OLED_ROTATION_0 = 0,        //!< 128x64 landscape
+    OLED_ROTATION_90,           //!< 64x128 portrait, panel turned a quarter clockwise
+    OLED_ROTATION_270,          //!< 64x128 portrait, panel turned a quarter counter-clockwise
+} oled_rotation_t;
+
+/**
+ * @brief How a bitmap is combined with the frame buffer
+ */
+typedef enum {
+    OLED_ROP_COPY = 0,          //!< Set pixels to the bitmap
+    OLED_ROP_OR,                //!< Turn on the pixels set in the bitmap
+    OLED_ROP_AND_NOT,           //!< Turn off the pixels set in the bitmap
+    OLED_ROP_XOR,               //!< Invert the pixels set in the bitmap
+} oled_rop_t;
+
+/**
+ * @brief Bitmap memory layouts
+ */
+typedef enum {
+    OLED_BITMAP_XBM = 0,        //!< Rows padded to whole bytes, leftmost pixel in bit 0
+    OLED_BITMAP_PAGES,          //!< GDDRAM layout: width column bytes per 8 rows, top row in bit 0
+} oled_bitmap_format_t;
+
+/**
+ * @brief Bitmap for oled_blit()
+ */
+typedef struct {
+    const uint8_t *data;
+    const uint8_t *mask;        //!< Optional, same size and layout as data, only pixels set here are drawn
+    int16_t width;
+    int16_t height;
+    oled_bitmap_format_t format;
+} oled_bitmap_t;
+
+/**
+ * @brief Horizontal alignment of the lines of a text box
+ */
+typedef enum {
+    OLED_ALIGN_LEFT = 0,
+    OLED_ALIGN_CENTER,
+    OLED_ALIGN_RIGHT,
+} oled_align_t;
+
+/**
+ * @brief Box and layout for oled_draw_text_box()
+ */
+typedef struct {
+    int16_t x;                  //!< Left column, may be off screen
+    int16_t y;                  //!< Top row, may be off screen
+    int16_t width;
+    int16_t height;
+    oled_align_t align;
+    uint8_t wrap;               //!< Break lines between words, a word wider than the box is broken anywhere
+    uint8_t ellipsis;           //!< End text that is cut with "..."
+    uint8_t line_spacing;       //!< Blank rows between lines
+} oled_text_box_t;
+
+/**
+ * @brief Run/literal packed image in GDDRAM layout, generated by src/tools/pack_image.py
+ */
+typedef struct {
+    uint8_t x;                  //!< Screen column of the left edge
+    uint8_t page;               //!< Screen page (8 rows) of the top edge
+    uint8_t width;              //!< Width in columns
+    uint8_t pages;              //!< Height in pages
+    const uint8_t *data;        //!< Packed stream
+    uint16_t data_len;
+} oled_packed_image_t;
+
+/**
+ * @brief Animation as a packed keyframe and one delta per frame, generated by src/tools/pack_anim.py
+ * 
+ * A delta is a list of runs, each a page and column relative to the animation window, the run
+ * length minus one and the new column bytes. A page byte of 0xFF ends the delta. Delta n turns
+ * frame n into frame n + 1, the last one turns the last frame back into the first.
+ */
+typedef struct {
+    uint8_t x;                  //!< Screen column of the left edge
+    uint8_t page;               //!< Screen page (8 rows) of the top edge
+    uint8_t width;              //!< Width in columns
+    uint8_t pages;              //!< Height in pages
+    uint16_t frame_count;
+    const uint8_t *keyframe;    //!< First frame, packed like oled_packed_image_t
+    uint16_t keyframe_len;
+    const uint8_t *deltas;      //!< frame_count deltas back to back
+    uint32_t deltas_len;
+} oled_anim_t;
+
+/**
+ * @brief Playback position of an animation
+ */
+typedef struct {
+    const oled_anim_t *anim;
+    uint16_t frame;             //!< Frame last applied
+    uint32_t offset;            //!< Start of its delta in anim->deltas
+} oled_anim_player_t;
+
+/**
+ * @brief Frame pacing counters
+ */
+typedef struct {
+    uint32_t presented;     //!< Frames pushed to the display
+    uint32_t dropped;       //!< Frames replaced by a newer one before they were sent
+} oled_frame_stats_t;
+
+/**
+ * @brief Glyph cache counters, shared by all displays
+ */
+typedef struct {
+    uint32_t hits;          //!< Glyphs drawn from RAM
+    uint32_t misses;        //!< Glyphs read from the font and converted
+    uint32_t evictions;     //!< Misses that replaced the least recently used glyph
+} oled_glyph_cache_stats_t;
+
+/**
+ * @brief One piece of a vectored transfer, sent without copying
+ */
+typedef struct {
+    const uint8_t *data;
+    uint32_t data_len;
+} oled_segment_t;
+
 /**
  * @brief Structure passed to the hardware interface callback
  */
@@ -27,24 +181,63 @@ typedef struct {
     oled_info_type_t info_type;
     uint8_t address;
     uint8_t register_add;
-    uint8_t *data;
+    const uint8_t *data;                //!< OLED_SEND_DATA payload
     uint32_t data_len;
+    const oled_segment_t *segments;     //!< OLED_SEND_SEGMENTS payload, sent back to back after register_add
+    uint32_t segment_count;
 } oled_info_t;
 
+/**
+ * @brief Handle of one display, returned by oled_create()
+ * @note Every function taking a handle accepts NULL for the default display set up by oled_init().
+ */
+typedef struct oled_dev *oled_handle_t;
+
+/**
+ * @brief Display configuration passed to oled_create()
+ */
+typedef struct {
+    uint8_t address;                                //!< 7 bit I2C address, e.g. 0x3C or 0x3D
+    uint32_t (*oled_callback)(oled_info_t *info);   //!< Hardware/I2C handler of the bus the display is on
+    uint32_t transport_flags;                       //!< OLED_TRANSPORT_* flags of the handler
+} oled_config_t;
+
 /* Public API */
 
 /**
- * @brief Initialize the OLED driver
+ * @brief Create and initialize one more display
+ * @param config Address and transport of the display
+ * @param handle Receives the display handle
+ * @return 0 on success, non-zero on failure or when all OLED_MAX_DISPLAYS are in use
+ * @note Displays on the same bus share the flush task, which interleaves their transfers chunk by chunk.
+ */
+uint32_t oled_create(const oled_config_t *config, oled_handle_t *handle);
+
+/**
+ * @brief Initialize the OLED driver and the default display at OLED_I2C_ADDRESS
  * @param oled_callback Function pointer to the hardware/I2C handler
  * @return 0 on success, non-zero on failure
  */
 uint32_t oled_init(uint32_t (*oled_callback)(oled_info_t *info));
 
+/**
+ * @brief Initialize the OLED driver with a transport that has extra capabilities
+ * @param oled_callback Function pointer to the hardware/I2C handler
+ * @param transport_flags OLED_TRANSPORT_* flags, with 0 this is the same as oled_init()
+ * @return 0 on success, non-zero on failure
+ */
+uint32_t oled_init_transport(uint32_t (*oled_callback)(oled_info_t *info), uint32_t transport_flags);
+
 /**
  * @brief Clear the display buffer and update the screen (turn all pixels off)
  */
 void oled_clear_display();
 
+/**
+ * @brief oled_clear_display() for one display
+ */
+void oled_clear_display_h(oled_handle_t handle);
+
 /**
  * @brief Display a string on the OLED
  * @param text Pointer to the string/data
@@ -52,30 +245,126 @@ void oled_clear_display();
  */
 void oled_display_text(uint8_t *text, uint32_t text_len);
 
+/**
+ * @brief oled_display_text() for one display
+ */
+void oled_display_text_h(oled_handle_t handle, uint8_t *text, uint32_t text_len);
+
 /**
  * @brief Render a string into the internal frame buffer
  * * @param font Pointer to the font definition
- * @param x Starting X coordinate
- * @param y Starting Y coordinate
- * @param str Null-terminated string to draw
+ * @param x Starting X coordinate, may be off screen
+ * @param y Starting Y coordinate, may be off screen
+ * @param str Null-terminated string to draw, clipped to the screen
  * @param foreground Color of the text
  * @param background Color of the background
  * @return int32_t Total width of the rendered string in pixels
  */
-int32_t oled_prepare_string_frame(const font_info_t *font, uint8_t x, uint8_t y, const char *str, 
+int32_t oled_prepare_string_frame(const font_info_t *font, int16_t x, int16_t y, const char *str, 
                                   oled_color_t foreground, oled_color_t background);
 
 /**
- * @brief Push the prepared frame buffer to the physical display
+ * @brief oled_prepare_string_frame() for one display
+ */
+int32_t oled_prepare_string_frame_h(oled_handle_t handle, const font_info_t *font, int16_t x, int16_t y, const char *str, 
+                                    oled_color_t foreground, oled_color_t background);
+
+/**
+ * @brief Lay out and draw text in a box
+ * @param handle Display, NULL for the default one
+ * @param font Pointer to the font definition
+ * @param box Position, size and layout of the text
+ * @param str Null-terminated string, '\n' starts a new line
+ * @param foreground Color of the text
+ * @param background Color the box is cleared to
+ * @return Number of characters laid out, less than the string length when the rest did not fit
+ * @note The string is measured once to find the lines and then drawn, glyphs are clipped to the box.
+ *       Up to OLED_TEXT_MAX_LINES lines are drawn.
+ */
+int32_t oled_draw_text_box(oled_handle_t handle, const font_info_t *font, const oled_text_box_t *box, const char *str,
+                           oled_color_t foreground, oled_color_t background);
+
+/**
+ * @brief Submit the prepared frame buffer, the flush task pushes it to the physical display
+ * @note Returns at once and drawing continues on a copy of the submitted frame.
+ *       A submitted frame that has not been sent yet is replaced by the newer one (latest wins).
  */
 void oled_display_prepared_frame();
 
+/**
+ * @brief oled_display_prepared_frame() for one display
+ */
+void oled_display_prepared_frame_h(oled_handle_t handle);
+
+/**
+ * @brief Wait until the last presented frame has been pushed to the display
+ * @param timeout_ms Maximum time to wait
+ * @return 0 when the transfer is complete, 1 on timeout
+ */
+uint32_t oled_wait_frame_done(uint32_t timeout_ms);
+
+/**
+ * @brief oled_wait_frame_done() for one display
+ */
+uint32_t oled_wait_frame_done_h(oled_handle_t handle, uint32_t timeout_ms);
+
+/**
+ * @brief Present submitted frames at a fixed rate, timed by esp_timer
+ * @param fps Target frames per second, 0 sends every frame as soon as the bus is free
+ * @return 0 on success, 1 when the timer could not be set up or fps is above OLED_FRAME_RATE_MAX (1000 by default),
+ *         a refused rate leaves the current one running
+ */
+uint32_t oled_set_frame_rate(uint32_t fps);
+
+/**
+ * @brief oled_set_frame_rate() for one display, every display has its own pacing timer
+ */
+uint32_t oled_set_frame_rate_h(oled_handle_t handle, uint32_t fps);
+
+/**
+ * @brief Read the presented and dropped frame counters
+ * @param stats Filled with the current counters
+ */
+void oled_get_frame_stats(oled_frame_stats_t *stats);
+
+/**
+ * @brief oled_get_frame_stats() for one display
+ */
+void oled_get_frame_stats_h(oled_handle_t handle, oled_frame_stats_t *stats);
+
+/**
+ * @brief Read the glyph cache counters
+ * @param stats Filled with the current counters
+ */
+void oled_get_glyph_cache_stats(oled_glyph_cache_stats_t *stats);
+
+/**
+ * @brief Clear the glyph cache counters
+ */
+void oled_reset_glyph_cache_stats(void);
+
 /**
  * @brief Load a raw XBM image into the frame buffer and display it
- * @param xbm Pointer to XBM data
+ * @param xbm Pointer to XBM data, a full screen image: 128x64, or 64x128 while rotated
  */
 void oled_load_xbm(uint8_t *xbm);
 
+/**
+ * @brief oled_load_xbm() for one display
+ */
+void oled_load_xbm_h(oled_handle_t handle, uint8_t *xbm);
+
+/**
+ * @brief Add an XBM image of any size to the frame buffer at x, y and display it
+ * @param handle Display, NULL for the default one
+ * @param xbm XBM data, rows padded to whole bytes
+ * @param x Left column, may be off screen
+ * @param y Top row, may be off screen
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ */
+void oled_load_xbm_at(oled_handle_t handle, const uint8_t *xbm, int16_t x, int16_t y, int16_t width, int16_t height);
+
 /**
  * @brief Invert the display colors
  * @param t 1 to invert, 0 for normal
@@ -83,6 +372,11 @@ void oled_load_xbm(uint8_t *xbm);
  */
 uint32_t oled_invert_display(uint8_t t);
 
+/**
+ * @brief oled_invert_display() for one display
+ */
+uint32_t oled_invert_display_h(oled_handle_t handle, uint8_t t);
+
 /**
  * @brief Flip the display scan direction (rotate 180 degrees effectively if combined with segment remap)
  * @param t 1 to reverse, 0 for normal
@@ -90,4 +384,225 @@ uint32_t oled_invert_display(uint8_t t);
  */
 uint32_t oled_reverse_display_scan(uint8_t t);
 
+/**
+ * @brief oled_reverse_display_scan() for one display
+ */
+uint32_t oled_reverse_display_scan_h(oled_handle_t handle, uint8_t t);
+
+/**
+ * @brief Set the panel contrast, nothing is sent when it is already set
+ * @param handle Display, NULL for the default one
+ * @param contrast 0 to 255
+ * @return 0 on success
+ */
+uint32_t oled_set_contrast(oled_handle_t handle, uint8_t contrast);
+
+/**
+ * @brief Switch the panel on or into sleep, GDDRAM is kept
+ * @param handle Display, NULL for the default one
+ * @param on 1 for on, 0 for off
+ * @return 0 on success
+ */
+uint32_t oled_set_display_on(oled_handle_t handle, uint8_t on);
+
+/**
+ * @brief Show pixels inverted (white background) without touching GDDRAM
+ * @param handle Display, NULL for the default one
+ * @param inverse 1 for inverted, 0 for normal
+ * @return 0 on success
+ */
+uint32_t oled_set_inverse(oled_handle_t handle, uint8_t inverse);
+
+/**
+ * @brief Start a continuous horizontal scroll done by the controller, no frame data is sent while it runs
+ * @param handle Display, NULL for the default one
+ * @param dir Scroll direction
+ * @param page0 First page scrolled
+ * @param page1 Last page scrolled
+ * @param speed Panel frames per one column step
+ * @return 0 on success
+ * @note Frames submitted meanwhile wait until oled_stop_scroll(), which also restores the scrolled pages.
+ * @note After oled_ring_scroll() the pages sit rotated in GDDRAM, a range that wraps around the ring
+ *       is refused (returns 1). The full range 0 to 7 is always accepted.
+ */
+uint32_t oled_start_scroll(oled_handle_t handle, oled_scroll_dir_t dir, uint8_t page0, uint8_t page1, oled_scroll_speed_t speed);
+
+/**
+ * @brief Start a continuous vertical and horizontal scroll done by the controller
+ * @param handle Display, NULL for the default one
+ * @param dir Horizontal direction
+ * @param page0 First page scrolled horizontally
+ * @param page1 Last page scrolled horizontally, page0 == page1 with a blank page gives a pure vertical scroll
+ * @param speed Panel frames per step
+ * @param vertical_offset Rows moved up per step, 0 to 63
+ * @param area_top Rows at the top kept still
+ * @param area_rows Rows scrolled vertically below area_top
+ * @return 0 on success
+ * @note page0 and page1 are refused like in oled_start_scroll() when they wrap around the GDDRAM ring
+ */
+uint32_t oled_start_diagonal_scroll(oled_handle_t handle, oled_scroll_dir_t dir, uint8_t page0, uint8_t page1, oled_scroll_speed_t speed,
+                                    uint8_t vertical_offset, uint8_t area_top, uint8_t area_rows);
+
+/**
+ * @brief Scroll the frame buffer by whole pages, using GDDRAM as a ring buffer
+ * @param handle Display, NULL for the default one
+ * @param pages Positive scrolls content up and clears the pages exposed at the bottom,
+ *              negative scrolls down and clears them at the top
+ * @note Drawing coordinates stay relative to the top of the screen. The next presented frame 
+ *       only sends the exposed pages plus one display start line command.
+ */
+void oled_ring_scroll(oled_handle_t handle, int8_t pages);
+
+/**
+ * @brief Stop a hardware scroll and rewrite the scrolled area from the frame buffer
+ * @param handle Display, NULL for the default one
+ * @return 0 on success
+ */
+uint32_t oled_stop_scroll(oled_handle_t handle);
+
+/**
+ * @brief Decode a packed image straight to the panel, a full screen or part of one
+ * @param handle Display, NULL for the default one
+ * @param image Image made by src/tools/pack_image.py
+ * @return 0 on success, 1 when the image is off screen, the stream is short or the transfer failed
+ * @note Bytes go out chunk by chunk as they are decoded and are copied into the frame buffer
+ *       as well, so later drawing continues on top of the image. Landscape coordinates only.
+ */
+uint32_t oled_show_packed_image(oled_handle_t handle, const oled_packed_image_t *image);
+
+/**
+ * @brief Draw the keyframe of an animation and present it
+ * @param handle Display, NULL for the default one
+ * @param player Playback position, set to the first frame
+ * @param anim Animation made by src/tools/pack_anim.py
+ * @return 0 on success, 1 when the animation is off screen or its keyframe is short,
+ *         oled_anim_next() then refuses to play it
+ * @note Landscape coordinates only. Nothing else should be drawn over the animation window
+ *       while it plays, the deltas only hold the bytes that change.
+ */
+uint32_t oled_anim_start(oled_handle_t handle, oled_anim_player_t *player, const oled_anim_t *anim);
+
+/**
+ * @brief Apply the delta to the next frame and present it, after the last frame playback wraps to the first
+ * @param handle Display, NULL for the default one
+ * @param player Playback position started by oled_anim_start()
+ * @return 0 on success, 1 when the player was not started or for a malformed delta,
+ *         the frame buffer then holds a partly applied frame
+ * @note Only the changed columns are marked dirty and sent. Pace playback with oled_set_frame_rate() 
+ *       and call oled_wait_frame_done() before each step, frames presented faster are dropped.
+ */
+uint32_t oled_anim_next(oled_handle_t handle, oled_anim_player_t *player);
+
+/**
+ * @brief Draw in portrait for panels mounted on their side
+ * @param handle Display, NULL for the default one
+ * @param rotation OLED_ROTATION_90 or OLED_ROTATION_270 for a 64x128 canvas, OLED_ROTATION_0 for landscape
+ * @return 0 on success, 1 for an unknown rotation or when built with OLED_PORTRAIT_CANVAS=0
+ * @note Drawing functions and text then use portrait coordinates. The canvas is rotated into
+ *       the frame when it is presented, only 8x8 tiles drawn since the last frame are rotated.
+ *       Changing the rotation clears the screen. oled_ring_scroll() and oled_display_text_h()
+ *       stay landscape and the ring scroll does nothing while rotated.
+ */
+uint32_t oled_set_rotation(oled_handle_t handle, oled_rotation_t rotation);
+
+/**
+ * @brief Set or clear a rectangle of the frame buffer
+ * @param handle Display, NULL for the default one
+ * @param x Left column, may be off screen
+ * @param y Top row, may be off screen
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param color OLED_COLOR_WHITE sets the pixels, OLED_COLOR_BLACK clears them
+ * @note Drawing functions only change the frame buffer, present it with oled_display_prepared_frame_h()
+ */
+void oled_fill_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, oled_color_t color);
+
+/**
+ * @brief Clear a rectangle of the frame buffer, same as oled_fill_rect() in black
+ */
+void oled_clear_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h);
+
+/**
+ * @brief Invert every pixel of a rectangle, e.g. for a highlight bar
+ */
+void oled_invert_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h);
+
+/**
+ * @brief Copy a rectangle of the frame buffer to another position, the two may overlap
+ * @param handle Display, NULL for the default one
+ * @param src_x Left column of the source
+ * @param src_y Top row of the source
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param dst_x Left column of the destination
+ * @param dst_y Top row of the destination
+ */
+void oled_copy_rect(oled_handle_t handle, int16_t src_x, int16_t src_y, int16_t w, int16_t h, int16_t dst_x, int16_t dst_y);
+
+/**
+ * @brief Draw a horizontal line of w pixels starting at x, y
+ */
+void oled_draw_hline(oled_handle_t handle, int16_t x, int16_t y, int16_t w, oled_color_t color);
+
+/**
+ * @brief Draw a vertical line of h pixels starting at x, y
+ */
+void oled_draw_vline(oled_handle_t handle, int16_t x, int16_t y, int16_t h, oled_color_t color);
+
+/**
+ * @brief Draw a line between two points, both ends included
+ * @note Like all drawing functions the coordinates may be off screen, the part on screen is drawn
+ */
+void oled_draw_line(oled_handle_t handle, int16_t x0, int16_t y0, int16_t x1, int16_t y1, oled_color_t color);
+
+/**
+ * @brief Draw the outline of a rectangle
+ */
+void oled_draw_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, oled_color_t color);
+
+/**
+ * @brief Draw the outline of a circle of radius r around cx, cy
+ */
+void oled_draw_circle(oled_handle_t handle, int16_t cx, int16_t cy, int16_t r, oled_color_t color);
+
+/**
+ * @brief Draw a filled circle of radius r around cx, cy
+ */
+void oled_fill_circle(oled_handle_t handle, int16_t cx, int16_t cy, int16_t r, oled_color_t color);
+
+/**
+ * @brief Draw the outline of a rectangle with corners of radius r, limited to half the shorter side
+ */
+void oled_draw_round_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, oled_color_t color);
+
+/**
+ * @brief Draw a filled rectangle with corners of radius r, limited to half the shorter side
+ */
+void oled_fill_round_rect(oled_handle_t handle, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, oled_color_t color);
+
+/**
+ * @brief Draw the outline of a triangle
+ */
+void oled_draw_triangle(oled_handle_t handle, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, oled_color_t color);
+
+/**
+ * @brief Draw a filled triangle
+ */
+void oled_fill_triangle(oled_handle_t handle, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, oled_color_t color);
+
+/**
+ * @brief Draw a bitmap of any size with its top left corner at x, y
+ * @param handle Display, NULL for the default one
+ * @param bitmap Image, mask and layout
+ * @param x Left column, may be off screen
+ * @param y Top row, may be off screen
+ * @param rop How the bitmap is combined with the frame buffer
+ */
+void oled_blit(oled_handle_t handle, const oled_bitmap_t *bitmap, int16_t x, int16_t y, oled_rop_t rop);
+
+#ifdef OLED_BENCHMARK
+/* Print the time of the frame buffer kernels and the XBM transpose against working one pixel at a time */
+void oled_benchmark(void);
+#endif
+
 #endif // __OLED_128X64_H__
\ No newline at end of file
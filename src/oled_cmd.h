@@ -21,6 +21,14 @@
 #define OLED_CMD_SET_MEMORY_ADDR_MODE   0x20    // follow with 0x00 = HORZ mode = Behave like a KS108 graphic LCD
 #define OLED_CMD_SET_COLUMN_RANGE       0x21    // can be used only in HORZ/VERT mode - follow with 0x00 and 0x7F = COL127
 #define OLED_CMD_SET_PAGE_RANGE         0x22    // can be used only in HORZ/VERT mode - follow with 0x00 and 0x07 = PAGE7
+#define OLED_CMD_SET_LOWER_COLUMN       0x00    // PAGE mode only - OR with the low nibble of the column
+#define OLED_CMD_SET_HIGHER_COLUMN      0x10    // PAGE mode only - OR with the high nibble of the column
+#define OLED_CMD_SET_PAGE_START         0xB0    // PAGE mode only - OR with the page 0..7
+
+// OLED_CMD_SET_MEMORY_ADDR_MODE values
+#define OLED_ADDR_MODE_HORIZONTAL       0x00
+#define OLED_ADDR_MODE_VERTICAL         0x01
+#define OLED_ADDR_MODE_PAGE             0x02
 
 // Hardware Config (pg.31)
 #define OLED_CMD_SET_DISPLAY_START_LINE 	0x40
@@ -41,7 +49,14 @@
 // Charge Pump (pg.62)
 #define OLED_CMD_SET_CHARGE_PUMP        0x8D    // follow with 0x14
 
+// Scrolling Command Table (pg.28)
+#define OLED_CMD_SCROLL_RIGHT               0x26    // follow with 0x00, start page, interval, end page, 0x00, 0xFF
+#define OLED_CMD_SCROLL_LEFT                0x27
+#define OLED_CMD_SCROLL_VERTICAL_RIGHT      0x29    // follow with 0x00, start page, interval, end page, vertical offset
+#define OLED_CMD_SCROLL_VERTICAL_LEFT       0x2A
+#define OLED_CMD_SET_VERTICAL_SCROLL_AREA   0xA3    // follow with fixed top rows, scrolled rows
 
 #define OLED_DEACTIVATE_SCROLL 0x2E
+#define OLED_ACTIVATE_SCROLL   0x2F
 
 #endif
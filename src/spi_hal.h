@@ -0,0 +1,91 @@
+#ifndef __SPI_HAL_H__
+#define __SPI_HAL_H__
+
+/* Every HSPI, GPIO and delay access of spi_interface.c goes through these few calls.
+   Built with SPI_INTERFACE_MOCK they are only declared, and a host test provides them
+   to record the D/C level and the FIFO bytes of each transfer (see test/). */
+
+#include "inttypes.h"
+#include "spi_interface.h"
+
+#ifndef SPI_INTERFACE_MOCK
+
+#include "driver/spi.h"
+#include "driver/gpio.h"
+#include "esp8266/spi_struct.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static inline uint32_t spi_hal_init(void)
+{
+    uint32_t ret_val = 0;
+    gpio_config_t io_conf =
+    {
+        (1 << SPI_DC_PIN) | (1 << SPI_RST_PIN),
+        GPIO_MODE_OUTPUT,
+        GPIO_PULLUP_DISABLE,
+        GPIO_PULLDOWN_DISABLE,
+        GPIO_INTR_DISABLE
+    };
+    if(gpio_config(&io_conf))
+    {
+        ret_val = 1;
+    }
+
+    spi_config_t conf;
+    conf.interface.val = SPI_DEFAULT_INTERFACE;
+    conf.interface.miso_en = 0;                                 // MISO pin drives D/C
+    conf.interface.byte_tx_order = SPI_BYTE_ORDER_LSB_FIRST;    // bytes go out in memory order
+    conf.intr_enable.val = SPI_MASTER_DEFAULT_INTR_ENABLE;
+    conf.mode = SPI_MASTER_MODE;
+    conf.clk_div = SPI_CLOCK_DIV;
+    conf.event_cb = NULL;
+    if(spi_init(HSPI_HOST, &conf))
+    {
+        ret_val = 1;
+    }
+    return ret_val;
+}
+
+/* 1 while the last transfer is still leaving the shift register */
+static inline uint8_t spi_hal_busy(void)
+{
+    return SPI1.cmd.usr;
+}
+
+static inline void spi_hal_set_dc(uint8_t level)
+{
+    gpio_set_level(SPI_DC_PIN, level);
+}
+
+static inline void spi_hal_set_reset(uint8_t level)
+{
+    gpio_set_level(SPI_RST_PIN, level);
+}
+
+static inline void spi_hal_delay_ms(uint32_t ms)
+{
+    vTaskDelay(ms / portTICK_PERIOD_MS);
+}
+
+/* Start one transfer of len bytes, at most SPI_INTERFACE_FIFO_SIZE, from word aligned memory */
+static inline uint32_t spi_hal_push(const uint32_t *words, uint32_t len)
+{
+    spi_trans_t trans = {0};
+    trans.mosi = (uint32_t *)words;
+    trans.bits.mosi = len * 8;
+    return spi_trans(HSPI_HOST, &trans) ? 1 : 0;
+}
+
+#else
+
+uint32_t spi_hal_init(void);
+uint8_t spi_hal_busy(void);
+void spi_hal_set_dc(uint8_t level);
+void spi_hal_set_reset(uint8_t level);
+void spi_hal_delay_ms(uint32_t ms);
+uint32_t spi_hal_push(const uint32_t *words, uint32_t len);
+
+#endif
+
+#endif
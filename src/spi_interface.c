@@ -0,0 +1,112 @@
+#include "spi_interface.h"
+#include "spi_hal.h"
+#include <stdio.h>
+#include <string.h>
+
+
+#ifdef SPI_INTERFACE_DEBUG
+#define spi_debug(fmt, ...) printf("\n %s: " fmt , "spi_interface", ## __VA_ARGS__)
+#else
+#define spi_debug(fmt, ...)
+#endif
+
+// FIFO image, the peripheral only loads whole 32 bit words
+static uint32_t g_fifo[SPI_INTERFACE_FIFO_SIZE / 4];
+static uint8_t g_dc_level = 0xFF;
+
+// spi_trans() returns once the transfer is started, wait for the last bits to leave
+static inline void spi_interface_wait_idle(void)
+{
+    while(spi_hal_busy());
+}
+
+static inline void spi_interface_set_dc(uint8_t dc)
+{
+    if(g_dc_level != dc)
+    {
+        spi_interface_wait_idle();
+        spi_hal_set_dc(dc);
+        g_dc_level = dc;
+    }
+}
+
+static uint32_t spi_interface_push(const uint32_t *words, uint32_t len)
+{
+    if(spi_hal_push(words, len))
+    {
+        spi_debug("Line 45: trans error");
+        return 1;
+    }
+    return 0;
+}
+
+uint32_t spi_interface_init(void)
+{
+    uint32_t ret_val = 0;
+    if(spi_hal_init())
+    {
+        ret_val = 1;
+        spi_debug("Line 62: gpio or spi init error");
+    }
+
+    // Reset pulse, the controller needs at least 3 us low
+    spi_hal_set_reset(0);
+    spi_hal_delay_ms(10);
+    spi_hal_set_reset(1);
+    spi_hal_delay_ms(10);
+    return ret_val;
+}
+
+uint32_t spi_interface_write_segments(uint8_t dc, const spi_interface_segment_t *segments, uint32_t segment_count)
+{
+    uint32_t ret_val = 0;
+    uint32_t staged = 0;
+
+    spi_interface_set_dc(dc);
+
+    for(uint32_t n = 0; n < segment_count; n++)
+    {
+        const uint8_t *data = segments[n].data;
+        uint32_t len = segments[n].data_len;
+
+        while(len)
+        {
+            // Word aligned blocks go straight to the FIFO without staging
+            if(staged == 0 && len >= SPI_INTERFACE_FIFO_SIZE && ((uintptr_t)data & 3) == 0)
+            {
+                ret_val |= spi_interface_push((const uint32_t *)data, SPI_INTERFACE_FIFO_SIZE);
+                data += SPI_INTERFACE_FIFO_SIZE;
+                len -= SPI_INTERFACE_FIFO_SIZE;
+                continue;
+            }
+
+            uint32_t copy = SPI_INTERFACE_FIFO_SIZE - staged;
+            if(copy > len)
+            {
+                copy = len;
+            }
+            // spi_trans() copies the words into the peripheral, g_fifo is free again on return
+            memcpy((uint8_t *)g_fifo + staged, data, copy);
+            staged += copy;
+            data += copy;
+            len -= copy;
+
+            if(staged == SPI_INTERFACE_FIFO_SIZE)
+            {
+                ret_val |= spi_interface_push(g_fifo, staged);
+                staged = 0;
+            }
+        }
+    }
+    if(staged)
+    {
+        ret_val |= spi_interface_push(g_fifo, staged);
+    }
+    return ret_val;
+}
+
+uint32_t spi_interface_write(uint8_t dc, const uint8_t *data, uint32_t data_len)
+{
+    spi_interface_segment_t segment = { data, data_len };
+    return spi_interface_write_segments(dc, &segment, 1);
+}
@@ -0,0 +1,26 @@
+#ifndef __SPI_INTERFACE_H__
+#define __SPI_INTERFACE_H__
+
+#include "inttypes.h"
+
+/* HSPI uses fixed pins: MOSI GPIO13 (D7), CLK GPIO14 (D5), CS GPIO15 (D8) */
+#define SPI_DC_PIN                  GPIO_NUM_12               /*!< gpio number for display data/command select (MISO pin is unused) */
+#define SPI_RST_PIN                 GPIO_NUM_16               /*!< gpio number for display reset */
+#define SPI_CLOCK_DIV               SPI_10MHz_DIV             /*!< SSD1306 accepts a serial clock up to 10 MHz */
+
+#define SPI_INTERFACE_FIFO_SIZE     64                        /*!< HSPI data buffer W0..W15 */
+#define SPI_INTERFACE_MAX_SEGMENTS  16
+
+/* One piece of a vectored write, referenced and never copied until it is loaded into the FIFO */
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t data_len;
+} spi_interface_segment_t;
+
+uint32_t spi_interface_init(void);
+/* dc: 0 for command bytes, 1 for display data */
+uint32_t spi_interface_write(uint8_t dc, const uint8_t *data, uint32_t data_len);
+uint32_t spi_interface_write_segments(uint8_t dc, const spi_interface_segment_t *segments, uint32_t segment_count);
+
+#endif
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Convert a sequence of XBM or PBM frames to an animation for oled_anim_start()/oled_anim_next().
+#
+# The first frame is stored packed like pack_image.py does. Every frame after it is stored as the
+# columns that changed, page by page:
+#   page, x, length - 1, length column bytes    one run, page and x relative to the animation window
+#   0xFF                                        end of the delta
+# The last delta turns the last frame back into the first, so playback loops without the keyframe.
+# Runs closer than --gap columns are merged, a run costs 3 bytes on top of its columns.
+
+import sys, os
+import argparse
+import re
+import time
+
+from pack_image import load_image, to_pages, pack, unpack, c_bytes
+
+DELTA_END = 0xFF
+RUN_HEADER = 3
+MAX_RUN = 0x100
+
+
+def delta_runs(old, new, width, pages, gap):
+    runs = []
+    for page in range(pages):
+        row_old = old[width * page:width * (page + 1)]
+        row_new = new[width * page:width * (page + 1)]
+        start = end = None
+        for x in range(width):
+            if row_old[x] == row_new[x]:
+                continue
+            if start is not None and x - end - 1 <= gap:
+                end = x
+                continue
+            if start is not None:
+                runs.append((page, start, row_new[start:end + 1]))
+            start = end = x
+        if start is not None:
+            runs.append((page, start, row_new[start:end + 1]))
+    return runs
+
+
+def encode_delta(runs):
+    out = []
+    for page, x, data in runs:
+        for i in range(0, len(data), MAX_RUN):
+            chunk = data[i:i + MAX_RUN]
+            out.extend([page, x + i, len(chunk) - 1])
+            out.extend(chunk)
+    out.append(DELTA_END)
+    return out
+
+
+def apply_delta(frame, delta, width):
+    frame = list(frame)
+    i = 0
+    while delta[i] != DELTA_END:
+        page, x, length = delta[i], delta[i + 1], delta[i + 2] + 1
+        frame[width * page + x:width * page + x + length] = delta[i + 3:i + 3 + length]
+        i += 3 + length
+    return frame, i + 1
+
+
+def main(args):
+    frames = []
+    for filename in args.frames:
+        width, height, pixels = load_image(filename)
+        if frames and (width, height) != (frames[0][0], frames[0][1]):
+            raise ValueError('%s is %dx%d, the first frame is %dx%d' % (filename, width, height, frames[0][0], frames[0][1]))
+        frames.append((width, height, to_pages(width, height, pixels)))
+
+    width, height = frames[0][0], frames[0][1]
+    pages = (height + 7) // 8
+    if args.x + width > 128 or args.page + pages > 8:
+        raise ValueError('%dx%d frames at column %d, page %d do not fit the screen' % (width, height, args.x, args.page))
+
+    keyframe = pack(frames[0][2])
+    assert unpack(keyframe, width * pages) == frames[0][2]
+
+    deltas = []
+    for i in range(len(frames)):
+        old, new = frames[i][2], frames[(i + 1) % len(frames)][2]
+        deltas.extend(encode_delta(delta_runs(old, new, width, pages, args.gap)))
+
+    # Play the whole loop back once
+    frame, offset = frames[0][2], 0
+    for i in range(len(frames)):
+        frame, used = apply_delta(frame, deltas[offset:], width)
+        offset += used
+        assert frame == frames[(i + 1) % len(frames)][2]
+
+    name = args.name or re.sub(r'\W', '_', os.path.splitext(os.path.basename(args.frames[0]))[0]).lower() + '_anim'
+    header_id = '__%s_H__' % name.upper()
+    print('''/**
+ * Animation generated by pack_anim.py from %s .. %s
+ * %d frames of %dx%d pixels, %d bytes from %d
+ * Created: %s
+ */
+#ifndef %s
+#define %s
+
+#include "oled_128x64.h"
+
+static const uint8_t %s_keyframe[] = {
+%s
+};
+
+static const uint8_t %s_deltas[] = {
+%s
+};
+
+static const oled_anim_t %s = {
+    .x            = %d,
+    .page         = %d,
+    .width        = %d,
+    .pages        = %d,
+    .frame_count  = %d,
+    .keyframe     = %s_keyframe,
+    .keyframe_len = sizeof(%s_keyframe),
+    .deltas       = %s_deltas,
+    .deltas_len   = sizeof(%s_deltas),
+};
+
+#endif /* %s */''' % (os.path.basename(args.frames[0]), os.path.basename(args.frames[-1]), len(frames), width, height,
+                      len(keyframe) + len(deltas), len(frames) * width * pages, time.ctime(), header_id, header_id,
+                      name, c_bytes(keyframe), name, c_bytes(deltas), name, args.x, args.page, width, pages,
+                      len(frames), name, name, name, name, header_id))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Pack XBM or PBM frames as a keyframe and deltas for oled_anim_next()')
+    parser.add_argument('frames', type=str, nargs='+', help='XBM or PBM (P1/P4) frames in playback order')
+    parser.add_argument('-n', '--name', type=str, help='C name of the animation, default from the first file name')
+    parser.add_argument('-x', type=int, help='Screen column of the left edge', default=0)
+    parser.add_argument('-p', '--page', type=int, help='Screen page (8 rows) of the top edge', default=0)
+    parser.add_argument('-g', '--gap', type=int, help='Merge runs at most this many unchanged columns apart', default=RUN_HEADER)
+    main(parser.parse_args(sys.argv[1:]))
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Convert an XBM or PBM image to a packed page-major image for oled_show_packed_image().
+#
+# Bytes are stored as the SSD1306 holds them in GDDRAM, one byte per column and 8 row page
+# with the top row in bit 0, page by page. The stream is run/literal packed:
+#   0x00..0x7F  n + 1 literal bytes follow
+#   0x80..0xFF  the next byte repeated (n & 0x7F) + 3 times
+# Runs and literals may cross page boundaries.
+
+import sys, os
+import argparse
+import re
+import time
+
+MIN_RUN = 3
+MAX_RUN = 0x7F + MIN_RUN
+MAX_LITERAL = 0x80
+
+
+def load_xbm(text):
+    width = int(re.search(r'#define\s+\w*_width\s+(\d+)', text).group(1))
+    height = int(re.search(r'#define\s+\w*_height\s+(\d+)', text).group(1))
+    body = text[text.index('{') + 1:text.rindex('}')]
+    data = [int(v, 16) for v in re.findall(r'0[xX][0-9a-fA-F]+', body)]
+    row_bytes = (width + 7) // 8
+    if len(data) < row_bytes * height:
+        raise ValueError('XBM data shorter than %dx%d' % (width, height))
+    # XBM rows are LSB first
+    return width, height, [[(data[row_bytes * y + x // 8] >> (x % 8)) & 1 for x in range(width)] for y in range(height)]
+
+
+def load_pbm(raw):
+    # Header tokens, comments start with '#'
+    tokens = []
+    pos = 0
+    while len(tokens) < 3:
+        while raw[pos:pos + 1].isspace():
+            pos += 1
+        if raw[pos:pos + 1] == b'#':
+            pos = raw.index(b'\n', pos)
+            continue
+        start = pos
+        while not raw[pos:pos + 1].isspace():
+            pos += 1
+        tokens.append(raw[start:pos])
+    magic, width, height = tokens[0], int(tokens[1]), int(tokens[2])
+    if magic == b'P1':
+        bits = [int(b) for b in re.findall(rb'[01]', raw[pos:])]
+        return width, height, [bits[width * y:width * (y + 1)] for y in range(height)]
+    if magic == b'P4':
+        data = raw[pos + 1:]
+        row_bytes = (width + 7) // 8
+        # PBM rows are MSB first
+        return width, height, [[(data[row_bytes * y + x // 8] >> (7 - x % 8)) & 1 for x in range(width)] for y in range(height)]
+    raise ValueError('Unsupported PBM type %s' % magic.decode())
+
+
+def load_image(filename):
+    with open(filename, 'rb') as f:
+        raw = f.read()
+    if raw.startswith(b'P1') or raw.startswith(b'P4'):
+        return load_pbm(raw)
+    return load_xbm(raw.decode('ascii', 'replace'))
+
+
+def to_pages(width, height, pixels):
+    pages = (height + 7) // 8
+    out = []
+    for page in range(pages):
+        for x in range(width):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < height and pixels[y][x]:
+                    byte |= 1 << bit
+            out.append(byte)
+    return out
+
+
+def pack(data):
+    out = []
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:MAX_LITERAL]
+            del literal[:MAX_LITERAL]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < MAX_RUN:
+            run += 1
+        if run >= MIN_RUN:
+            flush_literal()
+            out.append(0x80 | (run - MIN_RUN))
+            out.append(data[i])
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+    flush_literal()
+    return out
+
+
+def unpack(packed, size):
+    out = []
+    i = 0
+    while len(out) < size:
+        c = packed[i]
+        if c & 0x80:
+            out.extend([packed[i + 1]] * ((c & 0x7F) + MIN_RUN))
+            i += 2
+        else:
+            out.extend(packed[i + 1:i + 2 + c])
+            i += c + 2
+    return out
+
+
+def c_bytes(data, indent='    ', per_line=16):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append(indent + ', '.join('0x%02x' % b for b in data[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def main(args):
+    width, height, pixels = load_image(args.input)
+    if args.x + width > 128 or args.page * 8 + height > 64:
+        raise ValueError('%dx%d image at column %d, page %d does not fit the screen' % (width, height, args.x, args.page))
+
+    data = to_pages(width, height, pixels)
+    packed = pack(data)
+    assert unpack(packed, len(data)) == data
+
+    name = args.name or re.sub(r'\W', '_', os.path.splitext(os.path.basename(args.input))[0]).lower() + '_packed'
+    header_id = '__%s_H__' % name.upper()
+    print('''/**
+ * Packed page-major image generated by pack_image.py from %s
+ * %dx%d pixels, %d bytes packed from %d
+ * Created: %s
+ */
+#ifndef %s
+#define %s
+
+#include "oled_128x64.h"
+
+static const uint8_t %s_data[] = {
+%s
+};
+
+static const oled_packed_image_t %s = {
+    .x        = %d,
+    .page     = %d,
+    .width    = %d,
+    .pages    = %d,
+    .data     = %s_data,
+    .data_len = sizeof(%s_data),
+};
+
+#endif /* %s */''' % (os.path.basename(args.input), width, height, len(packed), len(data), time.ctime(),
+                      header_id, header_id, name, c_bytes(packed), name, args.x, args.page, width,
+                      (height + 7) // 8, name, name, header_id))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Pack an XBM or PBM image for oled_show_packed_image()')
+    parser.add_argument('input', type=str, help='XBM or PBM (P1/P4) image')
+    parser.add_argument('-n', '--name', type=str, help='C name of the image, default from the file name')
+    parser.add_argument('-x', type=int, help='Screen column of the left edge', default=0)
+    parser.add_argument('-p', '--page', type=int, help='Screen page (8 rows) of the top edge', default=0)
+    main(parser.parse_args(sys.argv[1:]))
@@ -0,0 +1,249 @@
+/*
+ * Host test of spi_interface.c against a mock HSPI peripheral.
+ * The mock records the D/C level and the FIFO bytes of every transfer, and keeps
+ * the peripheral busy for a few polls after each one, so a D/C change that does
+ * not wait for the previous transfer to leave the shift register is caught.
+ *
+ * make -C test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spi_interface.h"
+#include "spi_hal.h"
+
+#define MOCK_BUSY_POLLS     3
+#define MOCK_MAX_PUSHES     256
+
+typedef struct
+{
+    uint8_t dc;
+    uint32_t len;
+    uint8_t bytes[SPI_INTERFACE_FIFO_SIZE];
+    const uint32_t *words;          // Memory the transfer was started from
+} mock_push_t;
+
+static mock_push_t g_pushes[MOCK_MAX_PUSHES];
+static uint32_t g_push_count;
+static uint8_t g_dc = 0xFF;
+static uint32_t g_busy_polls;
+static uint32_t g_dc_while_busy;    // D/C changes while a transfer was still shifting out
+static uint32_t g_failures;
+
+uint32_t spi_hal_init(void)
+{
+    return 0;
+}
+
+uint8_t spi_hal_busy(void)
+{
+    if(g_busy_polls)
+    {
+        g_busy_polls--;
+        return 1;
+    }
+    return 0;
+}
+
+void spi_hal_set_dc(uint8_t level)
+{
+    if(g_busy_polls)
+    {
+        g_dc_while_busy++;
+    }
+    g_dc = level;
+}
+
+void spi_hal_set_reset(uint8_t level)
+{
+    (void)level;
+}
+
+void spi_hal_delay_ms(uint32_t ms)
+{
+    (void)ms;
+}
+
+uint32_t spi_hal_push(const uint32_t *words, uint32_t len)
+{
+    mock_push_t *push = &g_pushes[g_push_count++];
+    push->dc = g_dc;
+    push->len = len;
+    push->words = words;
+    memcpy(push->bytes, words, len);
+    g_busy_polls = MOCK_BUSY_POLLS;
+    return 0;
+}
+
+static void mock_reset(void)
+{
+    g_push_count = 0;
+    g_dc_while_busy = 0;
+}
+
+#define CHECK(cond, ...)                                    \
+    do {                                                    \
+        if(!(cond))                                         \
+        {                                                   \
+            printf("\n FAIL %s:%d: ", __func__, __LINE__);  \
+            printf(__VA_ARGS__);                            \
+            g_failures++;                                   \
+            return;                                         \
+        }                                                   \
+    } while(0)
+
+// The pushes of one write: each at most a FIFO, all but the last one full, all at one D/C level,
+// and together exactly the bytes of the segments
+static void check_write(uint8_t dc, const spi_interface_segment_t *segments, uint32_t segment_count, uint32_t first_push)
+{
+    uint8_t expected[1024];
+    uint32_t expected_len = 0;
+    uint32_t offset = 0;
+
+    for(uint32_t n = 0; n < segment_count; n++)
+    {
+        memcpy(&expected[expected_len], segments[n].data, segments[n].data_len);
+        expected_len += segments[n].data_len;
+    }
+
+    for(uint32_t p = first_push; p < g_push_count; p++)
+    {
+        CHECK(g_pushes[p].dc == dc, "push %u sent at D/C %u, expected %u", p, g_pushes[p].dc, dc);
+        CHECK(g_pushes[p].len > 0 && g_pushes[p].len <= SPI_INTERFACE_FIFO_SIZE, "push %u is %u bytes", p, g_pushes[p].len);
+        CHECK(p == g_push_count - 1 || g_pushes[p].len == SPI_INTERFACE_FIFO_SIZE, "push %u is short but not the last", p);
+        CHECK(offset + g_pushes[p].len <= expected_len, "more bytes pushed than written");
+        CHECK(memcmp(g_pushes[p].bytes, &expected[offset], g_pushes[p].len) == 0, "push %u bytes differ", p);
+        offset += g_pushes[p].len;
+    }
+    CHECK(offset == expected_len, "%u bytes pushed, %u written", offset, expected_len);
+    CHECK(g_dc_while_busy == 0, "D/C changed while a transfer was shifting out");
+}
+
+static void fill(uint8_t *data, uint32_t len, uint8_t seed)
+{
+    for(uint32_t i = 0; i < len; i++)
+    {
+        data[i] = (uint8_t)(seed + i * 7);
+    }
+}
+
+// Commands then data then commands again, the D/C pin switches only between transfers
+static void test_dc_sequencing(void)
+{
+    static const uint8_t cmd[] = { 0x21, 0x00, 0x7F, 0x22, 0x00, 0x07 };
+    static uint8_t data[200];
+    fill(data, sizeof(data), 1);
+
+    mock_reset();
+    CHECK(spi_interface_write(0, cmd, sizeof(cmd)) == 0, "command write failed");
+    check_write(0, &(spi_interface_segment_t){ cmd, sizeof(cmd) }, 1, 0);
+
+    uint32_t first = g_push_count;
+    CHECK(spi_interface_write(1, data, sizeof(data)) == 0, "data write failed");
+    check_write(1, &(spi_interface_segment_t){ data, sizeof(data) }, 1, first);
+
+    first = g_push_count;
+    CHECK(spi_interface_write(0, cmd, 1) == 0, "command write failed");
+    check_write(0, &(spi_interface_segment_t){ cmd, 1 }, 1, first);
+}
+
+// 63, 64 and 65 bytes, from aligned and unaligned memory
+static void test_fifo_boundaries(void)
+{
+    static uint32_t storage[64];
+    uint8_t *base = (uint8_t *)storage;
+    static const uint32_t lengths[] = { 63, 64, 65 };
+    fill(base, sizeof(storage), 3);
+
+    for(uint32_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+    {
+        for(uint32_t misalign = 0; misalign < 4; misalign++)
+        {
+            spi_interface_segment_t segment = { base + misalign, lengths[l] };
+            mock_reset();
+            CHECK(spi_interface_write_segments(1, &segment, 1) == 0, "write failed");
+            check_write(1, &segment, 1, 0);
+            CHECK(g_push_count == (lengths[l] + SPI_INTERFACE_FIFO_SIZE - 1) / SPI_INTERFACE_FIFO_SIZE,
+                  "%u bytes took %u transfers", lengths[l], g_push_count);
+            // A whole aligned FIFO goes out straight from the caller's memory
+            if(misalign == 0 && lengths[l] >= SPI_INTERFACE_FIFO_SIZE)
+            {
+                CHECK(g_pushes[0].words == storage, "aligned block of %u bytes was staged", lengths[l]);
+            }
+        }
+    }
+}
+
+// Segments of odd lengths at odd addresses are packed into full FIFOs across segment borders
+static void test_mixed_segments(void)
+{
+    static uint32_t storage[128];
+    uint8_t *base = (uint8_t *)storage;
+    fill(base, sizeof(storage), 5);
+
+    spi_interface_segment_t segments[] =
+    {
+        { base + 1, 1 },
+        { base + 10, 3 },
+        { base + 32, 64 },      // aligned but behind staged bytes
+        { base + 101, 65 },
+        { base + 200, 63 },
+        { base + 300, 5 },
+    };
+    uint32_t count = sizeof(segments) / sizeof(segments[0]);
+
+    mock_reset();
+    CHECK(spi_interface_write_segments(1, segments, count) == 0, "write failed");
+    check_write(1, segments, count, 0);
+
+    // The same bytes as commands right after, D/C switches once the data has left
+    uint32_t first = g_push_count;
+    CHECK(spi_interface_write_segments(0, segments, 2) == 0, "write failed");
+    check_write(0, segments, 2, first);
+}
+
+// Random segment lists and D/C levels
+static void test_random(void)
+{
+    static uint32_t storage[256];
+    uint8_t *base = (uint8_t *)storage;
+    fill(base, sizeof(storage), 9);
+    srand(1);
+
+    for(uint32_t round = 0; round < 2000; round++)
+    {
+        spi_interface_segment_t segments[SPI_INTERFACE_MAX_SEGMENTS];
+        uint32_t count = 1 + rand() % SPI_INTERFACE_MAX_SEGMENTS;
+        uint32_t total = 0;
+        uint8_t dc = rand() % 2;
+
+        for(uint32_t n = 0; n < count; n++)
+        {
+            uint32_t len = rand() % 130;
+            if(total + len > 1024)
+            {
+                len = 0;
+            }
+            segments[n].data = base + rand() % (sizeof(storage) - len);
+            segments[n].data_len = len;
+            total += len;
+        }
+
+        mock_reset();
+        CHECK(spi_interface_write_segments(dc, segments, count) == 0, "write failed");
+        check_write(dc, segments, count, 0);
+    }
+}
+
+int main(void)
+{
+    spi_interface_init();
+
+    test_dc_sequencing();
+    test_fifo_boundaries();
+    test_mixed_segments();
+    test_random();
+
+    printf("\n spi_interface: %s\n", g_failures ? "FAILED" : "passed");
+    return g_failures ? 1 : 0;
+}